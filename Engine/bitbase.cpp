@@ -0,0 +1,182 @@
+#include <vector>
+
+#include "attacks.h"
+#include "bitbase.h"
+#include "util.h"
+
+namespace Bitbase
+{
+	// The positions are normalized so that the pawn is white and on the files a to d, which leaves
+	// 24 pawn squares. One bit per position, the whole table is 24 KB.
+	const int PawnSquareCount = 24;
+	const int KpkSize = COLOR_NB * SQUARE_NB * SQUARE_NB * PawnSquareCount;
+
+	unsigned KpkTable[KpkSize / 32];
+
+	enum Result : unsigned char
+	{
+		UNKNOWN, WIN, DRAW, INVALID
+	};
+
+	static int index(Color to_move, Square white_king, Square black_king, Square pawn)
+	{
+		int pawn_index = (Util::getRank(pawn) - RANK_2) * 4 + Util::getFile(pawn);
+		return ((to_move * SQUARE_NB + white_king) * SQUARE_NB + black_king) * PawnSquareCount + pawn_index;
+	}
+
+	static Result initialResult(Color to_move, Square white_king, Square black_king, Square pawn)
+	{
+		if (white_king == black_king || white_king == pawn || black_king == pawn
+			|| Attacks::kingAttacks(white_king) & Constants::SquareBB[black_king])
+			return INVALID;
+
+		Bitboard pawn_attacks = Attacks::pawnAttacks<WHITE>(Constants::SquareBB[pawn]);
+
+		if (to_move == WHITE)
+		{
+			if (pawn_attacks & Constants::SquareBB[black_king])
+				return INVALID;
+
+			// The pawn promotes and can't be taken
+			Square promotion = Square(pawn + 8);
+			if (Util::getRank(pawn) == RANK_7 && promotion != white_king && promotion != black_king
+				&& (!(Attacks::kingAttacks(black_king) & Constants::SquareBB[promotion])
+					|| Attacks::kingAttacks(white_king) & Constants::SquareBB[promotion]))
+				return WIN;
+		}
+		else
+		{
+			Bitboard targets = Attacks::kingAttacks(black_king) & ~Attacks::kingAttacks(white_king) & ~pawn_attacks;
+
+			// Checkmate by the pawn, or stalemate
+			if (!targets)
+				return pawn_attacks & Constants::SquareBB[black_king] ? WIN : DRAW;
+
+			// The pawn is taken
+			if (targets & Constants::SquareBB[pawn])
+				return DRAW;
+		}
+		return UNKNOWN;
+	}
+
+	static Result classify(const std::vector<Result> &results, Color to_move, Square white_king, Square black_king, Square pawn)
+	{
+		// The side to move wins or draws if any move does, and loses it only if every move does
+		Result good = to_move == WHITE ? WIN : DRAW;
+		Result bad = to_move == WHITE ? DRAW : WIN;
+		bool all_bad = true;
+
+		auto visit = [&](int child) {
+			Result result = results[child];
+			if (result == good)
+				return true;
+			all_bad &= result == bad;
+			return false;
+		};
+
+		if (to_move == WHITE)
+		{
+			Bitboard targets = Attacks::kingAttacks(white_king) & ~Attacks::kingAttacks(black_king) & ~Constants::SquareBB[pawn];
+			for (Square target : BitboardIterator<Square>(targets))
+			{
+				if (visit(index(BLACK, target, black_king, pawn)))
+					return WIN;
+			}
+
+			// Promotions are decided by the initial results
+			Square push = Square(pawn + 8);
+			if (Util::getRank(pawn) < RANK_7 && push != white_king && push != black_king)
+			{
+				if (visit(index(BLACK, white_king, black_king, push)))
+					return WIN;
+
+				Square double_push = Square(pawn + 16);
+				if (Util::getRank(pawn) == RANK_2 && double_push != white_king && double_push != black_king
+					&& visit(index(BLACK, white_king, black_king, double_push)))
+					return WIN;
+			}
+		}
+		else
+		{
+			Bitboard targets = Attacks::kingAttacks(black_king) & ~Attacks::kingAttacks(white_king)
+				& ~Attacks::pawnAttacks<WHITE>(Constants::SquareBB[pawn]);
+			for (Square target : BitboardIterator<Square>(targets))
+			{
+				if (visit(index(WHITE, white_king, target, pawn)))
+					return DRAW;
+			}
+		}
+
+		return all_bad ? bad : UNKNOWN;
+	}
+
+	template <typename F>
+	static void forEachPosition(F f)
+	{
+		for (Color to_move : Colors)
+		{
+			for (Square white_king : Squares)
+			{
+				for (Square black_king : Squares)
+				{
+					for (Square pawn = A2; pawn <= H7; ++pawn)
+					{
+						if (Util::getFile(pawn) <= D_FILE)
+							f(to_move, white_king, black_king, pawn);
+					}
+				}
+			}
+		}
+	}
+
+	void init()
+	{
+		std::vector<Result> results(KpkSize);
+
+		forEachPosition([&](Color to_move, Square white_king, Square black_king, Square pawn) {
+			results[index(to_move, white_king, black_king, pawn)] = initialResult(to_move, white_king, black_king, pawn);
+		});
+
+		for (bool changed = true; changed; )
+		{
+			changed = false;
+			forEachPosition([&](Color to_move, Square white_king, Square black_king, Square pawn) {
+				Result &result = results[index(to_move, white_king, black_king, pawn)];
+				if (result == UNKNOWN)
+				{
+					result = classify(results, to_move, white_king, black_king, pawn);
+					changed |= result != UNKNOWN;
+				}
+			});
+		}
+
+		// What is still unknown can't be won
+		std::fill(KpkTable, KpkTable + KpkSize / 32, 0);
+		for (int i = 0; i < KpkSize; ++i)
+		{
+			if (results[i] == WIN)
+				KpkTable[i / 32] |= 1u << (i % 32);
+		}
+	}
+
+	bool probeKpk(Color strong, Square strong_king, Square pawn, Square weak_king, Color to_move)
+	{
+		if (strong == BLACK)
+		{
+			strong_king = Square(strong_king ^ 56);
+			pawn = Square(pawn ^ 56);
+			weak_king = Square(weak_king ^ 56);
+			to_move = ~to_move;
+		}
+
+		if (Util::getFile(pawn) > D_FILE)
+		{
+			strong_king = Square(strong_king ^ 7);
+			pawn = Square(pawn ^ 7);
+			weak_king = Square(weak_king ^ 7);
+		}
+
+		int i = index(to_move, strong_king, weak_king, pawn);
+		return (KpkTable[i / 32] >> (i % 32)) & 1;
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "types.h"
+
+// Win or draw bitbase of the king and pawn versus king ending, generated by retrograde analysis
+namespace Bitbase
+{
+	void init();
+
+	// Returns true if the side with the pawn wins, false if the position is a draw
+	bool probeKpk(Color strong, Square strong_king, Square pawn, Square weak_king, Color to_move);
+}
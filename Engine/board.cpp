@@ -296,9 +296,9 @@ bool Board::makeMove(Move move)
 	_fullmove_num += toMove();
 
 	if (move.pieceType() == PAWN || move.isCapture())
-		++_halfmove_clock;
-	else
 		_halfmove_clock = 0;
+	else
+		++_halfmove_clock;
 
 	_hash ^= Zobrist::BlackMovesHash;
 
@@ -327,29 +327,26 @@ int Board::phase() const
 	return (ret * 256 + (total / 2)) / total;
 }
 
-// TODO
 bool Board::isDraw() const
 {
-	if (material() > 3000)
-		return false;
+	if (_halfmove_clock >= 100)
+		return true;
 
 	if (numOfPieces(QUEEN) +
 		numOfPieces(ROOK) +
 		numOfPieces(PAWN) > 0)
 		return false;
 
-	if (numOfPieces(WHITE, KNIGHT) + numOfPieces(WHITE, BISHOP) > 0
-		&& numOfPieces(BLACK, KNIGHT) + numOfPieces(BLACK, BISHOP) > 0)
+	// At most one minor piece on each side
+	if (numOfPieces(WHITE, KNIGHT) + numOfPieces(WHITE, BISHOP) <= 1
+		&& numOfPieces(BLACK, KNIGHT) + numOfPieces(BLACK, BISHOP) <= 1)
 		return true;
 
-	for (Color color = WHITE; color < COLOR_NB; ++color)
-	{
-		Color o = ~color;
-		if (numOfPieces(color, KNIGHT) >= 2 || numOfPieces(color, BISHOP) >= 2)
-			return false;
-	}
+	// Only bishops, all of them on squares of the same color
+	const static Bitboard dark_squares = 0xAA55AA55AA55AA55ULL;
+	Bitboard bishops = pieces(WHITE, BISHOP) | pieces(BLACK, BISHOP);
 
-	return true;
+	return numOfPieces(KNIGHT) == 0 && (!(bishops & dark_squares) || !(bishops & ~dark_squares));
 }
 
 bool Board::canCastle(Color color, Side side) const
@@ -398,6 +395,47 @@ u64 Board::hash() const
 	return _hash;
 }
 
+u64 Board::hashAfter(Move move) const
+{
+	u64 hash = _hash ^ Zobrist::BlackMovesHash;
+
+	if (_en_passant_target != NO_SQUARE)
+		hash ^= Zobrist::EnPassantFileHash[Util::getFile(_en_passant_target)];
+
+	if (move.isNull())
+		return hash;
+
+	Color color = toMove();
+
+	if (move.isCastle())
+	{
+		Side side = move.isCastle(KINGSIDE) ? KINGSIDE : QUEENSIDE;
+		Square k_from = color == WHITE ? E1 : E8;
+		Square k_to = color == WHITE ? (side == KINGSIDE ? G1 : C1) : (side == KINGSIDE ? G8 : C8);
+		Square r_from = color == WHITE ? (side == KINGSIDE ? H1 : A1) : (side == KINGSIDE ? H8 : A8);
+		Square r_to = color == WHITE ? (side == KINGSIDE ? F1 : D1) : (side == KINGSIDE ? F8 : D8);
+
+		hash ^= Zobrist::PiecePositionHash[color][KING][k_from] ^ Zobrist::PiecePositionHash[color][KING][k_to];
+		hash ^= Zobrist::PiecePositionHash[color][ROOK][r_from] ^ Zobrist::PiecePositionHash[color][ROOK][r_to];
+	}
+	else
+	{
+		hash ^= Zobrist::PiecePositionHash[color][move.pieceType()][move.from()];
+		hash ^= Zobrist::PiecePositionHash[color][move.isPromotion() ? move.promotion() : move.pieceType()][move.to()];
+
+		Piece captured = pieceAt(move.to());
+		if (captured != NO_PIECE)
+			hash ^= Zobrist::PiecePositionHash[~color][toPieceType(captured)][move.to()];
+		else if (move.isEnPassant())
+			hash ^= Zobrist::PiecePositionHash[~color][PAWN][_en_passant_capture_target];
+
+		if (move.isDoublePush())
+			hash ^= Zobrist::EnPassantFileHash[Util::getFile(move.to())];
+	}
+
+	return hash ^ Zobrist::CastlingRightsHash[_castlingRightsAfter(move) ^ _castling_rights];
+}
+
 Board Board::flip() const
 {
 	Board board(*this);
@@ -440,6 +478,14 @@ Board Board::flip() const
 }
 
 void Board::_updateCastlingRights(const Move move)
+{
+	unsigned char new_castling_rights = _castlingRightsAfter(move);
+
+	_hash ^= Zobrist::CastlingRightsHash[new_castling_rights ^ _castling_rights];
+	_castling_rights = new_castling_rights;
+}
+
+unsigned char Board::_castlingRightsAfter(const Move move) const
 {
 	unsigned char new_castling_rights = _castling_rights;
 
@@ -457,8 +503,7 @@ void Board::_updateCastlingRights(const Move move)
 	else if (move.from() == H8 || move.to() == H8)
 		new_castling_rights &= ~CastleFlag[BLACK][KINGSIDE];
 
-	_hash ^= Zobrist::CastlingRightsHash[new_castling_rights ^ _castling_rights];
-	_castling_rights = new_castling_rights;
+	return new_castling_rights;
 }
 
 void Board::_makeNormalMove(Move move)
@@ -47,6 +47,7 @@ public:
 
 	int phase() const;
 
+	// True if the position is drawn by the fifty-move rule or neither side has enough material to win
 	bool isDraw() const;
 
 	bool canCastle(Color color, Side side) const;
@@ -64,6 +65,9 @@ public:
 
 	u64 hash() const;
 
+	// The hash of the position after the move, without making it
+	u64 hashAfter(Move move) const;
+
 	Board flip() const;
 
 	const static int AllCastlingRights;
@@ -74,6 +78,7 @@ public:
 private:
 	void _castle(Side side);
 	void _updateCastlingRights(Move move);
+	unsigned char _castlingRightsAfter(Move move) const;
 	void _makeNormalMove(Move move);
 
 	template <Color color>
@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "book.h"
+#include "moveselect.h"
+#include "zobrist.h"
+
+Book::Book() : _entry_count(0), _rng(std::random_device()())
+{
+}
+
+Book::~Book()
+{
+	close();
+}
+
+bool Book::open(const std::string &path)
+{
+	close();
+
+	if (!_file.open(path))
+		return false;
+
+	if (_file.size() % _Entry_Size != 0)
+	{
+		close();
+		return false;
+	}
+
+	_entry_count = _file.size() / _Entry_Size;
+	return true;
+}
+
+void Book::close()
+{
+	_file.close();
+	_entry_count = 0;
+}
+
+bool Book::isOpen() const
+{
+	return _file.isOpen();
+}
+
+template <Color toMove>
+static Move findLegalMove(const Board &board, Square from, Square to, PieceType promotion)
+{
+	MoveSelect::MoveSelector<toMove, false> mg(board);
+	for (; !mg.end(); mg.next())
+	{
+		Move move = mg.curr();
+		if (move.from() != from || move.to() != to || (move.isPromotion() ? move.promotion() : NO_PIECE_TYPE) != promotion)
+			continue;
+
+		Board board_copy = board;
+		if (board_copy.makeMove(move))
+			return move;
+	}
+	return Move();
+}
+
+static Move findLegalMove(const Board &board, Square from, Square to, PieceType promotion)
+{
+	if (board.toMove() == WHITE)
+		return findLegalMove<WHITE>(board, from, to, promotion);
+	else
+		return findLegalMove<BLACK>(board, from, to, promotion);
+}
+
+Move Book::probe(const Board &board, bool best)
+{
+	if (!isOpen())
+		return Move();
+
+	u64 key = Zobrist::polyglotKey(board);
+	std::vector<std::pair<Move, unsigned>> moves;
+	unsigned total_weight = 0;
+
+	for (size_t i = _lowerBound(key); i < _entry_count; ++i)
+	{
+		Entry entry = _entry(i);
+		if (entry.key != key)
+			break;
+
+		// Entries that don't decode to a legal move come from a hash collision
+		Move move = _decodeMove(board, entry.move);
+		if (move.isValid() && entry.weight > 0)
+		{
+			moves.push_back(std::make_pair(move, (unsigned)entry.weight));
+			total_weight += entry.weight;
+		}
+	}
+
+	if (moves.empty())
+		return Move();
+
+	if (best)
+	{
+		auto best_move = moves.begin();
+		for (auto it = moves.begin(); it != moves.end(); ++it)
+		{
+			if (it->second > best_move->second)
+				best_move = it;
+		}
+		return best_move->first;
+	}
+
+	unsigned pick = std::uniform_int_distribution<unsigned>(0, total_weight - 1)(_rng);
+	for (auto &move : moves)
+	{
+		if (pick < move.second)
+			return move.first;
+		pick -= move.second;
+	}
+	return moves.back().first;
+}
+
+bool Book::build(const std::string &games_file, const std::string &book_file, int max_ply)
+{
+	std::ifstream in(games_file);
+	if (!in)
+		return false;
+
+	std::map<std::pair<u64, unsigned short>, unsigned> counts;
+
+	std::string line;
+	while (std::getline(in, line))
+	{
+		Board board = Board::fromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+		std::istringstream iss(line);
+		std::string token;
+
+		for (int ply = 0; ply < max_ply && iss >> token; ++ply)
+		{
+			Move move;
+			try
+			{
+				move = Move::fromAlgebraic(board, token);
+			}
+			catch (const MoveParseError &)
+			{
+				break;
+			}
+
+			move = findLegalMove(board, move.from(), move.to(), move.isPromotion() ? move.promotion() : NO_PIECE_TYPE);
+			if (!move.isValid())
+				break;
+
+			++counts[std::make_pair(Zobrist::polyglotKey(board), _encodeMove(move))];
+			board.makeMove(move);
+		}
+	}
+
+	std::ofstream out(book_file, std::ios::binary);
+	if (!out)
+		return false;
+
+	// The map is ordered by key, as the binary search requires
+	for (auto &count : counts)
+	{
+		unsigned char entry[_Entry_Size] = { 0 };
+		unsigned weight = std::min(count.second, 0xFFFFu);
+
+		for (int i = 0; i < 8; ++i)
+			entry[i] = (unsigned char)(count.first.first >> (56 - 8 * i));
+		entry[8] = (unsigned char)(count.first.second >> 8);
+		entry[9] = (unsigned char)count.first.second;
+		entry[10] = (unsigned char)(weight >> 8);
+		entry[11] = (unsigned char)weight;
+
+		out.write((const char *)entry, _Entry_Size);
+	}
+	return true;
+}
+
+Book::Entry Book::_entry(size_t index) const
+{
+	const unsigned char *p = _file.data() + index * _Entry_Size;
+
+	Entry entry;
+	entry.key = 0;
+	for (int i = 0; i < 8; ++i)
+		entry.key = (entry.key << 8) | p[i];
+	entry.move = (unsigned short)((p[8] << 8) | p[9]);
+	entry.weight = (unsigned short)((p[10] << 8) | p[11]);
+	return entry;
+}
+
+size_t Book::_lowerBound(u64 key) const
+{
+	size_t low = 0, high = _entry_count;
+	while (low < high)
+	{
+		size_t mid = low + (high - low) / 2;
+		if (_entry(mid).key < key)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+// Polyglot packs the move as the target file and rank, the source file and rank, and the promoted
+// piece (1 knight to 4 queen), three bits each. Castling is written as the king taking its rook.
+Move Book::_decodeMove(const Board &board, unsigned short move)
+{
+	Square to = (Square)(((move >> 3) & 7) * 8 + (move & 7));
+	Square from = (Square)(((move >> 9) & 7) * 8 + ((move >> 6) & 7));
+	int promotion = (move >> 12) & 7;
+
+	if (toPieceType(board.pieceAt(from)) == KING && toPieceType(board.pieceAt(to)) == ROOK
+		&& pieceColor(board.pieceAt(to)) == board.toMove())
+	{
+		to = (Square)(to > from ? from + 2 : from - 2);
+	}
+
+	return findLegalMove(board, from, to, promotion ? (PieceType)promotion : NO_PIECE_TYPE);
+}
+
+unsigned short Book::_encodeMove(Move move)
+{
+	Square from = move.from(), to = move.to();
+
+	if (move.isCastle(KINGSIDE))
+		to = (Square)(from + 3);
+	else if (move.isCastle(QUEENSIDE))
+		to = (Square)(from - 4);
+
+	int promotion = move.isPromotion() ? move.promotion() : 0;
+	return (unsigned short)((promotion << 12) | (from << 6) | to);
+}
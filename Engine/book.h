@@ -0,0 +1,58 @@
+#pragma once
+
+#include <random>
+#include <string>
+
+#include "board.h"
+#include "mapped_file.h"
+#include "move.h"
+#include "types.h"
+
+// Opening book in the Polyglot file format: 16 byte big endian entries of key, move, weight and
+// learn value, sorted by key. The keys are Polyglot keys, so books made by other tools can be used.
+class Book
+{
+public:
+	Book();
+	~Book();
+
+	Book(const Book &other) = delete;
+	Book& operator=(const Book &other) = delete;
+
+	// Maps the file into memory, returns false if it can't be mapped or isn't a book
+	bool open(const std::string &path);
+	void close();
+	bool isOpen() const;
+
+	// Returns a legal book move of the position, or an invalid move if there is none. The move is
+	// the one with the highest weight if best is set, otherwise chosen randomly by weight.
+	Move probe(const Board &board, bool best);
+
+	// Writes a book of the first max_ply moves of the games. The input has one game per line, as
+	// moves in coordinate notation from the starting position, and the weight of a book move is
+	// the number of games it was played in. Returns false if a file can't be opened.
+	static bool build(const std::string &games_file, const std::string &book_file, int max_ply);
+
+private:
+	struct Entry
+	{
+		u64 key;
+		unsigned short move;
+		unsigned short weight;
+	};
+
+	const static size_t _Entry_Size = 16;
+
+	MappedFile _file;
+	size_t _entry_count;
+
+	std::mt19937 _rng;
+
+	Entry _entry(size_t index) const;
+
+	// Index of the first entry of the key
+	size_t _lowerBound(u64 key) const;
+
+	static Move _decodeMove(const Board &board, unsigned short move);
+	static unsigned short _encodeMove(Move move);
+};
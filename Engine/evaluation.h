@@ -1,25 +1,35 @@
 #pragma once
 
 #include "attack_tables.h"
+#include "bitbase.h"
 #include "board.h"
+#include "evaluation_params.h"
 #include "piece_square_table.h"
 #include "types.h"
 
 namespace Evaluation
 {
-	extern const Score PieceValue[PIECE_TYPE_NB];
-	extern const Score Mobility[PIECE_TYPE_NB][32];
-	extern const Score TempoBonus;
-	extern const Score BishopPair;
-	extern const Score PawnIslands[5];
-	extern const Score PassedPawn[8];
-	extern const Score DoubledPawn[8];
-	extern const Score IsolatedPawn[8];
-	extern const Score HalfOpenFileBonus;
-	extern const Score OpenFileBonus;
-	extern const int KingAttacks[200];
-	extern const int KingAttacksWeight[PIECE_TYPE_NB];
+	// The piece values used by the search (material counting, SEE, move ordering), always the defaults
+	extern const Score (&PieceValue)[PIECE_TYPE_NB];
 
+	// Counts how many times each tunable evaluation term was applied for each color.
+	// Only filled when evaluate is instantiated with trace = true (used by the tuner).
+	struct Trace
+	{
+		Trace() { memset(this, 0, sizeof(*this)); }
+
+		int piece_value[PIECE_TYPE_NB][COLOR_NB];
+		int mobility[PIECE_TYPE_NB][32][COLOR_NB];
+		int tempo_bonus[COLOR_NB];
+		int pawn_islands[5][COLOR_NB];
+		int passed_pawn[8][COLOR_NB];
+		int doubled_pawn[8][COLOR_NB];
+		int isolated_pawn[8][COLOR_NB];
+		int half_open_file_bonus[COLOR_NB];
+		int open_file_bonus[COLOR_NB];
+		int king_attacks[200][COLOR_NB];
+		int piece_square[PIECE_TYPE_NB][SQUARE_NB][COLOR_NB];
+	};
 
 	template <Color color>
 	bool isPassedPawn(Square pawn, Bitboard enemy_pawns)
@@ -41,10 +51,14 @@ namespace Evaluation
 	bool isIsolated(int file, Bitboard pieces);
 	int islandCount(Bitboard pieces);
 
-	template <Color color>
-	Score evaluatePawnStructure(const Board & board)
+	template <Color color, bool trace = false>
+	Score evaluatePawnStructure(const Board & board, const Params &params, Trace *t = nullptr)
 	{
-		Score score = PawnIslands[islandCount(board.pieces(color, PAWN))];
+		int islands = islandCount(board.pieces(color, PAWN));
+		Score score = params.PawnIslands[islands];
+
+		if (trace)
+			t->pawn_islands[islands][color]++;
 
 		for (File file = A_FILE; file < FILE_NB; ++file)
 		{
@@ -54,23 +68,36 @@ namespace Evaluation
 				continue;
 
 			if (isIsolated(file, board.pieces(color, PAWN)))
-				score += IsolatedPawn[file];
+			{
+				score += params.IsolatedPawn[file];
+				if (trace)
+					t->isolated_pawn[file][color]++;
+			}
 
 			if (Util::popCount(Constants::FileBB[file] & pawns) >= 2)
-				score += DoubledPawn[file];
+			{
+				score += params.DoubledPawn[file];
+				if (trace)
+					t->doubled_pawn[file][color]++;
+			}
 
 			for (Square pawn : BitboardIterator<Square>(pawns))
 			{
 				if (isPassedPawn<color>(pawn, board.pieces(~color, PAWN)))
-					score += PassedPawn[Util::relativeRank<color>(Util::getRank(pawn))];
+				{
+					Rank rank = Util::relativeRank<color>(Util::getRank(pawn));
+					score += params.PassedPawn[rank];
+					if (trace)
+						t->passed_pawn[rank][color]++;
+				}
 			}
 		}
 
 		return score;
 	}
 
-	template <Color color>
-	Score evaluateRooks(const Board & board)
+	template <Color color, bool trace = false>
+	Score evaluateRooks(const Board & board, const Params &params, Trace *t = nullptr)
 	{
 		Score score;
 
@@ -81,9 +108,17 @@ namespace Evaluation
 			if (!(board.pieces(color, PAWN) & front_squares))
 			{
 				if (!(board.pieces(~color, PAWN) & front_squares))
-					score += OpenFileBonus;
+				{
+					score += params.OpenFileBonus;
+					if (trace)
+						t->open_file_bonus[color]++;
+				}
 				else
-					score += HalfOpenFileBonus;
+				{
+					score += params.HalfOpenFileBonus;
+					if (trace)
+						t->half_open_file_bonus[color]++;
+				}
 			}
 		}
 
@@ -120,12 +155,32 @@ namespace Evaluation
 	}
 
 
+	// Scores the king and pawn versus king ending exactly from the bitbase. Won positions get a
+	// score above any material balance that grows as the pawn advances, so the search pushes it.
 	template <Color color>
-	int evaluate(const Board & board)
+	int evaluateKpk(const Board & board)
+	{
+		Color strong = board.pieces(WHITE, PAWN) ? WHITE : BLACK;
+		Square pawn = Util::bitScanForward(board.pieces(strong, PAWN));
+
+		if (!Bitbase::probeKpk(strong, board.kingSquare(strong), pawn, board.kingSquare(~strong), board.toMove()))
+			return SCORE_DRAW;
+
+		Rank rank = strong == WHITE ? Util::getRank(pawn) : Util::relativeRank<BLACK>(Util::getRank(pawn));
+		int score = SCORE_KNOWN_WIN + 100 * rank;
+		return strong == color ? score : -score;
+	}
+
+	template <Color color, bool trace = false>
+	int evaluate(const Board & board, const Params &params, Trace *t = nullptr)
 	{
 		if (board.isDraw())
 			return 0;
 
+		// The tuner needs the terms of the evaluation, so it doesn't use the bitbase
+		if (!trace && Util::popCount(board.occupied()) == 3 && board.numOfPieces(PAWN) == 1)
+			return evaluateKpk<color>(board);
+
 		Score score;
 
 		Square king_square[COLOR_NB];
@@ -140,8 +195,14 @@ namespace Evaluation
 
 		for (PieceType piece_type = PAWN; piece_type <= QUEEN; ++piece_type)
 		{
-			score += PieceValue[piece_type] * Util::popCount(board.pieces(color, piece_type));
-			score -= PieceValue[piece_type] * Util::popCount(board.pieces(~color, piece_type));
+			score += params.PieceValue[piece_type] * Util::popCount(board.pieces(color, piece_type));
+			score -= params.PieceValue[piece_type] * Util::popCount(board.pieces(~color, piece_type));
+
+			if (trace)
+			{
+				t->piece_value[piece_type][color] += Util::popCount(board.pieces(color, piece_type));
+				t->piece_value[piece_type][~color] += Util::popCount(board.pieces(~color, piece_type));
+			}
 		}
 
 		for (PieceType piece_type = PAWN; piece_type < PIECE_TYPE_NB; ++piece_type)
@@ -150,20 +211,34 @@ namespace Evaluation
 			{
 				int distance = DistanceTable[square][king_square[~color]];
 				Bitboard attacked = board.attacked(square);
-				king_attacks_count[~color] += KingAttacksWeight[piece_type] * Util::popCount(king_proximity[~color] & attacked) + (7 - distance);
+				king_attacks_count[~color] += params.KingAttacksWeight[piece_type] * Util::popCount(king_proximity[~color] & attacked) + (7 - distance);
 
-				score += pieceSquareValue<color>(piece_type, square);
-				score += Mobility[piece_type][Util::popCount(board.attacked(square) & ~board.occupied())];
+				int mobility = Util::popCount(board.attacked(square) & ~board.occupied());
+				score += pieceSquareValue<color>(piece_type, square, params);
+				score += params.Mobility[piece_type][mobility];
+
+				if (trace)
+				{
+					t->piece_square[piece_type][Util::relativeSquare<color>(square)][color]++;
+					t->mobility[piece_type][mobility][color]++;
+				}
 			}
 
 			for (Square square : BitboardIterator<Square>(board.pieces(~color, piece_type)))
 			{
 				int distance = DistanceTable[square][king_square[color]];
 				Bitboard attacked = board.attacked(square);
-				king_attacks_count[color] += KingAttacksWeight[piece_type] * Util::popCount(king_proximity[color] & attacked) + (7 - distance);
+				king_attacks_count[color] += params.KingAttacksWeight[piece_type] * Util::popCount(king_proximity[color] & attacked) + (7 - distance);
+
+				int mobility = Util::popCount(board.attacked(square) & ~board.occupied());
+				score -= pieceSquareValue<~color>(piece_type, square, params);
+				score -= params.Mobility[piece_type][mobility];
 
-				score -= pieceSquareValue<~color>(piece_type, square);
-				score -= Mobility[piece_type][Util::popCount(board.attacked(square) & ~board.occupied())];
+				if (trace)
+				{
+					t->piece_square[piece_type][Util::relativeSquare<~color>(square)][~color]++;
+					t->mobility[piece_type][mobility][~color]++;
+				}
 			}
 		}
 
@@ -176,20 +251,35 @@ namespace Evaluation
 		score += evaluateKingSafety<color>(board);
 		score -= evaluateKingSafety<~color>(board);
 
-		score += evaluatePawnStructure<color>(board);
-		score -= evaluatePawnStructure<~color>(board);
+		score += evaluatePawnStructure<color, trace>(board, params, t);
+		score -= evaluatePawnStructure<~color, trace>(board, params, t);
+
+		score += evaluateRooks<color, trace>(board, params, t);
+		score -= evaluateRooks<~color, trace>(board, params, t);
 
-		score += evaluateRooks<color>(board);
-		score -= evaluateRooks<~color>(board);
+		score -= Score(params.KingAttacks[king_attacks_count[color]], params.KingAttacks[king_attacks_count[color]] / 2);
+		score += Score(params.KingAttacks[king_attacks_count[~color]], params.KingAttacks[king_attacks_count[~color]] / 2);
 
-		score -= Score(KingAttacks[king_attacks_count[color]], KingAttacks[king_attacks_count[color]] / 2);
-		score += Score(KingAttacks[king_attacks_count[~color]], KingAttacks[king_attacks_count[~color]] / 2);
+		if (trace)
+		{
+			// king_attacks_count[c] measures the attacks on c's king, so it counts for the other side
+			t->king_attacks[king_attacks_count[color]][~color]++;
+			t->king_attacks[king_attacks_count[~color]][color]++;
+			t->tempo_bonus[board.toMove()]++;
+		}
 
 		if(board.toMove() == color)
-			score += TempoBonus;
+			score += params.TempoBonus;
 		else
-			score -= TempoBonus;
+			score -= params.TempoBonus;
 
 		return (score.mg * (256 - board.phase()) + score.eg * board.phase()) / 256;
 	}
+
+	// Evaluates with the runtime parameters if they were loaded, otherwise with the built-in defaults
+	template <Color color>
+	int evaluate(const Board & board)
+	{
+		return evaluate<color>(board, activeParams());
+	}
 }
\ No newline at end of file
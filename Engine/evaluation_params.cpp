@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "evaluation_params.h"
+
+namespace Evaluation
+{
+	Params CustomParams = DefaultParams;
+	bool UseCustomParams = false;
+
+	static_assert(sizeof(Score) == 2 * sizeof(int), "Score arrays are read and written as int arrays");
+
+	struct Field
+	{
+		const char *name;
+		int *values;
+		int count;
+	};
+
+	// The entries of the parameter file, each one is a name followed by the values of the field in memory order
+	static std::vector<Field> _fields(Params &params)
+	{
+		return {
+			{ "PieceValue", &params.PieceValue[0].mg, 2 * PIECE_TYPE_NB },
+			{ "Mobility", &params.Mobility[0][0].mg, 2 * PIECE_TYPE_NB * 32 },
+			{ "TempoBonus", &params.TempoBonus.mg, 2 },
+			{ "BishopPair", &params.BishopPair.mg, 2 },
+			{ "PawnIslands", &params.PawnIslands[0].mg, 2 * 5 },
+			{ "PassedPawn", &params.PassedPawn[0].mg, 2 * 8 },
+			{ "DoubledPawn", &params.DoubledPawn[0].mg, 2 * 8 },
+			{ "IsolatedPawn", &params.IsolatedPawn[0].mg, 2 * 8 },
+			{ "HalfOpenFileBonus", &params.HalfOpenFileBonus.mg, 2 },
+			{ "OpenFileBonus", &params.OpenFileBonus.mg, 2 },
+			{ "KingAttacks", &params.KingAttacks[0], 200 },
+			{ "KingAttacksWeight", &params.KingAttacksWeight[0], PIECE_TYPE_NB },
+			{ "PieceSquareTable", &params.PieceSquareTable[0][0][0], PIECE_TYPE_NB * 2 * SQUARE_NB },
+		};
+	}
+
+	const Params &activeParams()
+	{
+		return UseCustomParams ? CustomParams : DefaultParams;
+	}
+
+	void loadParams(const std::string &file)
+	{
+		Params params;
+		loadParams(file, params);
+
+		CustomParams = params;
+		UseCustomParams = true;
+	}
+
+	void loadParams(const std::string &file, Params &params)
+	{
+		std::ifstream in(file);
+		if (!in)
+			throw ParamsParseError(("Error opening file: " + file).c_str());
+
+		Params loaded = DefaultParams;
+		std::vector<Field> fields = _fields(loaded);
+
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::stringstream ss(line);
+			std::string name;
+
+			if (!(ss >> name) || name[0] == '#')
+				continue;
+
+			auto field = std::find_if(fields.begin(), fields.end(), [&](const Field &f) { return name == f.name; });
+			if (field == fields.end())
+				throw ParamsParseError(("Unknown parameter: " + name).c_str());
+
+			for (int i = 0; i < field->count; ++i)
+			{
+				if (!(ss >> field->values[i]))
+					throw ParamsParseError(("Not enough values for parameter: " + name).c_str());
+			}
+		}
+
+		params = loaded;
+	}
+
+	void saveParams(const Params &params, const std::string &file)
+	{
+		std::ofstream out(file);
+		if (!out)
+			throw ParamsParseError(("Error creating file: " + file).c_str());
+
+		Params copy = params;
+		for (const Field &field : _fields(copy))
+		{
+			out << field.name;
+			for (int i = 0; i < field.count; ++i)
+				out << " " << field.values[i];
+			out << std::endl;
+		}
+	}
+
+	void resetParams()
+	{
+		UseCustomParams = false;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <exception>
+#include <string>
+
+#include "types.h"
+
+namespace Evaluation
+{
+	// All the weights of the evaluation function
+	struct Params
+	{
+		Score PieceValue[PIECE_TYPE_NB];
+		Score Mobility[PIECE_TYPE_NB][32];
+		Score TempoBonus;
+		Score BishopPair;
+		Score PawnIslands[5];
+		Score PassedPawn[8];
+		Score DoubledPawn[8];
+		Score IsolatedPawn[8];
+		Score HalfOpenFileBonus;
+		Score OpenFileBonus;
+		int KingAttacks[200];
+		int KingAttacksWeight[PIECE_TYPE_NB];
+		int PieceSquareTable[PIECE_TYPE_NB][2][SQUARE_NB];
+	};
+
+	// The built-in weights
+	extern const Params DefaultParams;
+
+	// Weights loaded at runtime, used instead of DefaultParams if UseCustomParams is set
+	extern Params CustomParams;
+	extern bool UseCustomParams;
+
+	class ParamsParseError : std::exception
+	{
+	public:
+		ParamsParseError(const char *msg) : exception(msg) {}
+	};
+
+	const Params &activeParams();
+
+	// Loads the parameter file into CustomParams and enables them, throws ParamsParseError on failure.
+	// Entries missing from the file keep their default values.
+	void loadParams(const std::string &file);
+
+	// Loads the parameter file into params without touching CustomParams, same rules as above
+	void loadParams(const std::string &file, Params &params);
+	void saveParams(const Params &params, const std::string &file);
+
+	// Switches back to DefaultParams
+	void resetParams();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+
+#include "move.h"
+#include "types.h"
+
+namespace MoveSelect
+{
+	// Statistics of quiet moves for move ordering, updated when a quiet move causes a beta cutoff
+	struct History
+	{
+		// The entries are kept in the range [-Max, Max]
+		const static int Max = 16384;
+
+		// Indexed by [color][from][to]
+		int butterfly[COLOR_NB][SQUARE_NB][SQUARE_NB];
+
+		// Indexed by [color][piece][to] of the previous move, then by [piece][to] of the current move
+		int continuation[COLOR_NB][PIECE_TYPE_NB][SQUARE_NB][PIECE_TYPE_NB][SQUARE_NB];
+
+		void clear()
+		{
+			std::memset(this, 0, sizeof(*this));
+		}
+
+		template <Color toMove>
+		int score(Move move, Move prev_move) const
+		{
+			int score = butterfly[toMove][move.from()][move.to()];
+			if (prev_move.isValid() && !prev_move.isNull())
+				score += continuation[toMove][prev_move.pieceType()][prev_move.to()][move.pieceType()][move.to()];
+			return score;
+		}
+
+		template <Color toMove>
+		void update(Move move, Move prev_move, int bonus)
+		{
+			_update(butterfly[toMove][move.from()][move.to()], bonus);
+			if (prev_move.isValid() && !prev_move.isNull())
+				_update(continuation[toMove][prev_move.pieceType()][prev_move.to()][move.pieceType()][move.to()], bonus);
+		}
+
+	private:
+		// Gravity update, the closer the entry is to the limit the less it changes
+		static void _update(int &entry, int bonus)
+		{
+			entry += bonus - entry * std::abs(bonus) / Max;
+		}
+	};
+}
@@ -0,0 +1,101 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+MappedFile::MappedFile() : _data(nullptr), _size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string &path)
+{
+	close();
+
+	const void *data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+	if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+	{
+		// The view keeps the mapping alive after the handles are closed
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping)
+		{
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			size = (size_t)file_size.QuadPart;
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+	{
+		void *mapped = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (mapped != MAP_FAILED)
+		{
+			data = mapped;
+			size = (size_t)file_stat.st_size;
+		}
+	}
+	::close(fd);
+#endif
+
+	if (!data)
+		return false;
+
+	_data = (const unsigned char *)data;
+	_size = size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (_data)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(_data);
+#else
+		munmap((void *)_data, _size);
+#endif
+	}
+
+	_data = nullptr;
+	_size = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+	return _data != nullptr;
+}
+
+const unsigned char *MappedFile::data() const
+{
+	return _data;
+}
+
+size_t MappedFile::size() const
+{
+	return _size;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+
+// A file mapped read only into memory
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile &other) = delete;
+	MappedFile& operator=(const MappedFile &other) = delete;
+
+	// Returns false if the file can't be opened or is empty
+	bool open(const std::string &path);
+	void close();
+	bool isOpen() const;
+
+	const unsigned char *data() const;
+	size_t size() const;
+
+private:
+	const unsigned char *_data;
+	size_t _size;
+};
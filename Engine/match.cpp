@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "match.h"
+#include "movegen.h"
+#include "search.h"
+
+namespace Match
+{
+	struct State
+	{
+		std::atomic<int> next_game;
+		std::atomic<bool> stop;
+
+		std::mutex mutex;
+		int wins = 0;
+		int losses = 0;
+		int draws = 0;
+	};
+
+	static double _expectedScore(double elo)
+	{
+		return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+	}
+
+	double sprtLLR(int wins, int losses, int draws, double elo0, double elo1)
+	{
+		int games = wins + losses + draws;
+		if (games == 0)
+			return 0.0;
+
+		double score = (wins + draws / 2.0) / games;
+		double variance = (wins * std::pow(1.0 - score, 2) + draws * std::pow(0.5 - score, 2) + losses * std::pow(score, 2)) / games;
+
+		// Every game had the same result, there is nothing to go by yet
+		if (variance == 0.0)
+			return 0.0;
+
+		double s0 = _expectedScore(elo0);
+		double s1 = _expectedScore(elo1);
+
+		return (s1 - s0) * (2 * score - s0 - s1) / (2 * variance / games);
+	}
+
+	template <Color toMove>
+	static bool _hasLegalMove(const Board &board)
+	{
+		Move moves[MAX_MOVES];
+		int move_count;
+
+		MoveGen::genMoves<toMove, false>(board, moves, move_count);
+		for (int i = 0; i < move_count; ++i)
+		{
+			Board board_copy = board;
+			if (board_copy.makeMove(moves[i]))
+				return true;
+		}
+
+		return false;
+	}
+
+	static bool _parseOpening(const std::string &line, Board &board)
+	{
+		std::stringstream ss(line), fen;
+		std::string token;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			if (!(ss >> token))
+				return false;
+			fen << token << " ";
+		}
+
+		std::string halfmove_clock, fullmove_num;
+		if (ss >> halfmove_clock >> fullmove_num && std::isdigit(halfmove_clock[0]) && std::isdigit(fullmove_num[0]))
+			fen << halfmove_clock << " " << fullmove_num;
+		else
+			fen << "0 1";
+
+		try
+		{
+			board = Board::fromFen(fen.str());
+		}
+		catch (FenParseError e)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	// Plays a game from the given position, returns the score of white (1, 0.5 or 0)
+	static double _playGame(Board board, Search::Search *engines[COLOR_NB], const Settings &settings)
+	{
+		std::vector<u64> history = { board.hash() };
+		std::chrono::milliseconds clock[COLOR_NB] = { std::chrono::milliseconds(settings.base_time), std::chrono::milliseconds(settings.base_time) };
+
+		// The index of the first position of the history after the last irreversible move
+		size_t reversible_start = 0;
+
+		for (int ply = 0; ply < settings.max_plies; ++ply)
+		{
+			Color color = board.toMove();
+
+			bool has_legal_move = color == WHITE ? _hasLegalMove<WHITE>(board) : _hasLegalMove<BLACK>(board);
+			if (!has_legal_move)
+			{
+				if (!board.isInCheck(color))
+					return 0.5;
+				return color == WHITE ? 0.0 : 1.0;
+			}
+
+			if (board.isDraw() || std::count(history.begin(), history.end(), board.hash()) >= 3)
+				return 0.5;
+
+			Search::Search &engine = *engines[color];
+			if (settings.base_time)
+			{
+				engine.setClock(color, clock[color]);
+				engine.setClock(~color, clock[~color]);
+				engine.setIncrement(color, std::chrono::milliseconds(settings.increment));
+				engine.setIncrement(~color, std::chrono::milliseconds(settings.increment));
+			}
+
+			engine.setGameHistory(std::vector<u64>(history.begin() + reversible_start, history.end() - 1));
+
+			Move move;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			engine.search(board, &move, true);
+
+			if (settings.base_time)
+			{
+				clock[color] -= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+				if (clock[color] < std::chrono::milliseconds(0))
+					return color == WHITE ? 0.0 : 1.0;
+				clock[color] += std::chrono::milliseconds(settings.increment);
+			}
+
+			// An illegal move loses the game
+			if (!move.isValid() || !board.makeMove(move))
+				return color == WHITE ? 0.0 : 1.0;
+
+			if (RepetitionTable::isIrreversible(move))
+				reversible_start = history.size();
+			history.push_back(board.hash());
+		}
+
+		return 0.5;
+	}
+
+	static void _configure(Search::Search &engine, const Evaluation::Params &params, const Settings &settings)
+	{
+		engine.setHashSize(settings.hash_size);
+		engine.setEvalParams(params);
+
+		if (settings.depth)
+			engine.setMaxDepth(settings.depth);
+		if (settings.nodes)
+			engine.setMaxNodes(settings.nodes);
+		if (settings.movetime)
+			engine.setMoveTime(std::chrono::milliseconds(settings.movetime));
+	}
+
+	static void _printStatus(const State &state, double llr, double lower, double upper, const std::function<void(const std::string&)> &output)
+	{
+		int games = state.wins + state.losses + state.draws;
+		double score = (state.wins + state.draws / 2.0) / games;
+		double elo = score <= 0.0 || score >= 1.0 ? (score <= 0.0 ? -999.0 : 999.0) : 400.0 * std::log10(score / (1.0 - score));
+
+		std::ostringstream status;
+		status << "info string games " << games
+			<< " +" << state.wins << " -" << state.losses << " =" << state.draws
+			<< std::fixed << std::setprecision(1)
+			<< " score " << score * 100.0 << "%"
+			<< " elo " << elo
+			<< std::setprecision(2)
+			<< " llr " << llr << " (" << lower << ", " << upper << ")";
+		output(status.str());
+	}
+
+	static void _worker(const std::vector<Board> &openings, const Settings &settings, State &state,
+		const std::function<void(const std::string&)> &output)
+	{
+		Search::Search candidate, baseline;
+		_configure(candidate, settings.params, settings);
+		_configure(baseline, Evaluation::DefaultParams, settings);
+
+		const double lower = std::log(settings.beta / (1.0 - settings.alpha));
+		const double upper = std::log((1.0 - settings.beta) / settings.alpha);
+
+		while (!state.stop)
+		{
+			int game = state.next_game++;
+			if (game >= settings.games)
+				break;
+
+			// Every opening is played twice, with the candidate playing both colors
+			const Board &opening = openings[(game / 2) % openings.size()];
+			bool candidate_white = game % 2 == 0;
+
+			Search::Search *engines[COLOR_NB];
+			engines[WHITE] = candidate_white ? &candidate : &baseline;
+			engines[BLACK] = candidate_white ? &baseline : &candidate;
+
+			double white_score = _playGame(opening, engines, settings);
+			double score = candidate_white ? white_score : 1.0 - white_score;
+
+			std::lock_guard<std::mutex> lock(state.mutex);
+
+			if (score == 1.0)
+				++state.wins;
+			else if (score == 0.0)
+				++state.losses;
+			else
+				++state.draws;
+
+			double llr = sprtLLR(state.wins, state.losses, state.draws, settings.elo0, settings.elo1);
+			_printStatus(state, llr, lower, upper, output);
+
+			if (!state.stop && (llr <= lower || llr >= upper))
+			{
+				state.stop = true;
+				output(std::string("info string SPRT: ") + (llr >= upper ? "H1" : "H0") + " accepted");
+			}
+		}
+	}
+
+	void run(const std::string &openings_file, const Settings &settings, const std::function<void(const std::string&)> &output)
+	{
+		std::ifstream in(openings_file);
+		if (!in)
+		{
+			output("Error opening file \"" + openings_file + "\"");
+			return;
+		}
+
+		std::vector<Board> openings;
+		std::string line;
+		while (std::getline(in, line))
+		{
+			Board board;
+			if (_parseOpening(line, board))
+				openings.push_back(board);
+		}
+
+		if (openings.empty())
+		{
+			output("No openings in file \"" + openings_file + "\"");
+			return;
+		}
+
+		Settings s = settings;
+		if (!s.depth && !s.nodes && !s.movetime && !s.base_time)
+			s.depth = 5;
+
+		int thread_count = s.threads > 0 ? s.threads : std::max(1, (int)std::thread::hardware_concurrency());
+
+		State state;
+		state.next_game = 0;
+		state.stop = false;
+
+		std::vector<std::thread> threads;
+		for (int i = 0; i < thread_count; ++i)
+			threads.emplace_back(_worker, std::cref(openings), std::cref(s), std::ref(state), std::cref(output));
+
+		for (std::thread &thread : threads)
+			thread.join();
+
+		if (!state.stop)
+			output("info string SPRT: no decision after " + std::to_string(state.wins + state.losses + state.draws) + " games");
+	}
+}
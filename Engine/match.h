@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "evaluation_params.h"
+#include "types.h"
+
+namespace Match
+{
+	// A match between the candidate (evaluating with params) and the baseline (evaluating with
+	// Evaluation::DefaultParams)
+	struct Settings
+	{
+		// The weights of the candidate, the active evaluation by default
+		Evaluation::Params params = Evaluation::activeParams();
+
+		// The maximum number of games, the match stops earlier if the SPRT reaches a decision
+		int games = 1000;
+
+		// Number of games played at the same time, 0 means one per hardware thread
+		int threads = 0;
+
+		// Search limits per move, a value of 0 means no limit. If no limit is given, depth 5 is used.
+		int depth = 0;
+		u64 nodes = 0;
+		int movetime = 0;
+
+		// Clock per game and increment per move in milliseconds, used if base_time is not 0
+		int base_time = 0;
+		int increment = 0;
+
+		// Hash size of each engine in megabytes
+		size_t hash_size = 16;
+
+		// Games longer than this are adjudicated as draws
+		int max_plies = 400;
+
+		// SPRT parameters, H0: elo = elo0, H1: elo = elo1
+		double elo0 = 0.0;
+		double elo1 = 5.0;
+		double alpha = 0.05;
+		double beta = 0.05;
+	};
+
+	// Log-likelihood ratio of H1 against H0 for the given results (normal approximation of the trinomial model)
+	double sprtLLR(int wins, int losses, int draws, double elo0, double elo1);
+
+	// Plays the openings in the file (one FEN/EPD per line) with both colors until the
+	// number of games is reached or the SPRT accepts one of the hypotheses. The progress and the
+	// errors are passed to output line by line, from one thread at a time.
+	void run(const std::string &openings_file, const Settings &settings, const std::function<void(const std::string&)> &output);
+}
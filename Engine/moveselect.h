@@ -2,6 +2,7 @@
 
 #include "board.h"
 #include "config.h"
+#include "history.h"
 #include "movegen.h"
 
 #include <vector>
@@ -21,8 +22,10 @@ namespace MoveSelect
 	class MoveSelector
 	{
 	public:
-		MoveSelector(const Board & board, Move hash_move = Move(), const std::pair<Move, Move> &killer_moves = std::make_pair(Move(), Move()))
-			: _board(board), _hash_move(hash_move), _killer_moves(killer_moves), _pos(0), _curr_hash_move(true)
+		MoveSelector(const Board & board, Move hash_move = Move(), const std::pair<Move, Move> &killer_moves = std::make_pair(Move(), Move()),
+			Move counter_move = Move(), const History *history = nullptr, Move prev_move = Move())
+			: _board(board), _hash_move(hash_move), _killer_moves(killer_moves), _counter_move(counter_move), _history(history), _prev_move(prev_move),
+			_pos(0), _curr_hash_move(true)
 		{
 			if (!_hash_move.isValid())
 			{
@@ -33,6 +36,18 @@ namespace MoveSelect
 			}
 		}
 
+		// Returns the given moves in the given order
+		MoveSelector(const Board & board, const Move *moves, int move_count)
+			: _board(board), _hash_move(), _killer_moves(_NoKillers), _counter_move(), _history(nullptr), _prev_move(),
+			_move_count(move_count), _pos(0), _curr_hash_move(false)
+		{
+			for (int i = 0; i < move_count; ++i)
+			{
+				_moves[i] = moves[i];
+				_scores[i] = move_count - i;
+			}
+		}
+
 		Move curr() const
 		{
 			if (_curr_hash_move)
@@ -55,7 +70,7 @@ namespace MoveSelect
 			if (_pos < _move_count)
 				_selectNext();
 
-			if (_moves[_pos] == _hash_move)
+			if (_pos < _move_count && _moves[_pos] == _hash_move)
 				next();
 		}
 
@@ -76,12 +91,24 @@ namespace MoveSelect
 					if (quiescence)
 						_scores[i] = mvvlva(_board, _moves[i]) * 10;
 					else
+					{
 						_scores[i] = see<toMove>(_board, _moves[i]) * 10;
+						if (_scores[i] < 0)
+							_scores[i] += SCORE_BAD_CAPTURE;
+					}
 				}
 				else if (!quiescence && (_moves[i] == _killer_moves.first || _moves[i] == _killer_moves.second))
 				{
 					_scores[i] = SCORE_KILLER;
 				}
+				else if (!quiescence && _moves[i] == _counter_move)
+				{
+					_scores[i] = SCORE_COUNTER_MOVE;
+				}
+				else if (_history)
+				{
+					_scores[i] = SCORE_QUIET + _history->score<toMove>(_moves[i], _prev_move) + pieceSquareEval<toMove>(_moves[i]);
+				}
 				else
 				{
 					_scores[i] = pieceSquareEval<toMove>(_moves[i]);
@@ -108,10 +135,18 @@ namespace MoveSelect
 		const Board & _board;
 		Move _hash_move;
 		const std::pair<Move, Move> &_killer_moves;
+		Move _counter_move;
+		const History *_history;
+		Move _prev_move;
 		Move _moves[MAX_MOVES];
 		int _scores[MAX_MOVES];
 		int _move_count;
 		int _pos;
 		bool _curr_hash_move;
+
+		static const std::pair<Move, Move> _NoKillers;
 	};
+
+	template <Color toMove, bool quiescence>
+	const std::pair<Move, Move> MoveSelector<toMove, quiescence>::_NoKillers = std::make_pair(Move(), Move());
 }
\ No newline at end of file
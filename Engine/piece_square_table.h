@@ -1,156 +1,15 @@
 #pragma once
 
+#include "evaluation_params.h"
 #include "types.h"
 #include "util.h"
 
 namespace Evaluation
 {
-	const static int PieceSquareTable[PIECE_TYPE_NB][2][SQUARE_NB] =
-	{
-		// PAWN
-		{
-			{
-				0, 0, 0, 0, 0, 0, 0, 0,
-				5, 10, 15, 0, 0, 15, 10, 5,
-				5, -5, -10, 0, 0, -10, -5, 5,
-				0, 0, 0, 20, 20, 0, 0, 0,
-				5, 5, 10, 25, 25, 10, 5, 5,
-				10, 10, 20, 30, 30, 20, 10, 10,
-				50, 50, 50, 50, 50, 50, 50, 50,
-				0, 0, 0, 0, 0, 0, 0, 0
-			},
-			{
-				0, 0, 0, 0, 0, 0, 0, 0,
-				0, 0, 0, 0, 0, 0, 0, 0,
-				0, 0, 0, 0, 0, 0, 0, 0,
-				0, 0, 0, 0, 0, 0, 0, 0,
-				5, 5, 10, 25, 25, 10, 5, 5,
-				10, 10, 20, 30, 30, 20, 10, 10,
-				50, 50, 50, 50, 50, 50, 50, 50,
-				0, 0, 0, 0, 0, 0, 0, 0
-			}
-		},
-		// KINGHT
-		{
-			{
-				-50, -20, -30, -30, -30, -30, -20, -50,
-				-40, -20, 0, 0, 0, 0, -20, -40,
-				-30, 0, 10, 15, 15, 10, 0, -30,
-				-30, 5, 15, 20, 20, 15, 5, -30,
-				-30, 0, 15, 20, 20, 15, 0, -30,
-				-30, 5, 10, 15, 15, 10, 5, -30,
-				-40, -20, 0, 5, 5, 0, -20, -40,
-				-50, -40, -30, -30, -30, -30, -40, -50
-			},
-			{
-				-50, -20, -30, -30, -30, -30, -20, -50,
-				-40, -20, 0, 0, 0, 0, -20, -40,
-				-30, 0, 10, 15, 15, 10, 0, -30,
-				-30, 5, 15, 20, 20, 15, 5, -30,
-				-30, 0, 15, 20, 20, 15, 0, -30,
-				-30, 5, 10, 15, 15, 10, 5, -30,
-				-40, -20, 0, 5, 5, 0, -20, -40,
-				-50, -40, -30, -30, -30, -30, -40, -50,
-			}
-		},
-		// BISHOP
-		{
-			{
-				-20, -10, -10, -10, -10, -10, -10, -20,
-				-10, 5, 0, 0, 0, 0, 5, -10,
-				-10, 10, 10, 10, 10, 10, 10, -10,
-				-10, 0, 20, 10, 10, 20, 0, -10,
-				-10, 5, 5, 10, 10, 5, 5, -10,
-				-10, 0, 5, 10, 10, 5, 0, -10,
-				-10, 0, 0, 0, 0, 0, 0, -10,
-				-20, -10, -10, -10, -10, -10, -10, -20,
-			},
-			{
-				-20, -10, -10, -10, -10, -10, -10, -20,
-				-10, 5, 0, 0, 0, 0, 5, -10,
-				-10, 10, 10, 10, 10, 10, 10, -10,
-				-10, 0, 20, 10, 10, 20, 0, -10,
-				-10, 5, 5, 10, 10, 5, 5, -10,
-				-10, 0, 5, 10, 10, 5, 0, -10,
-				-10, 0, 0, 0, 0, 0, 0, -10,
-				-20, -10, -10, -10, -10, -10, -10, -20,
-			}
-		},
-		// ROOK
-		{
-			{
-				0, 0, 0, 5, 5, 0, 0, 0,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				5, 10, 20, 20, 20, 20, 10, 5,
-				0, 0, 0, 0, 0, 0, 0, 0
-			},
-			{
-				0, 0, 0, 5, 5, 0, 0, 0,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				5, 10, 20, 20, 20, 20, 10, 5,
-				0, 0, 0, 0, 0, 0, 0, 0
-			}
-		},
-		// QUEEN
-		{
-			{
-				-20, -5, -5, 0, 0, -5, -5, -20,
-				-10, 0, 0, 0, 0, 0, 0, -10,
-				-5, 0, 5, 5, 5, 5, 0, -5,
-				-5, 0, 5, 5, 5, 5, 0, -5,
-				-5, 0, 5, 5, 5, 5, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				0, 5, 10, 10, 10, 10, 5, 0,
-				0, 0, 0, 0, 0, 0, 0, 0
-			},
-			{
-				-20, -5, -5, 0, 0, -5, -5, -20,
-				-10, 0, 0, 0, 0, 0, 0, -10,
-				-5, 0, 5, 5, 5, 5, 0, -5,
-				-5, 0, 5, 5, 5, 5, 0, -5,
-				-5, 0, 5, 5, 5, 5, 0, -5,
-				-5, 0, 0, 0, 0, 0, 0, -5,
-				0, 5, 10, 10, 10, 10, 5, 0,
-				0, 0, 0, 0, 0, 0, 0, 0
-			}
-		},
-		// KING
-		{
-			{
-				20, 30, 10, 0, 0, 10, 35, 20,
-				20, 10, 0, 0, 0, 0, 10, 20,
-				-10, -20, -20, -20, -20, -20, -20, -10,
-				-20, -30, -30, -40, -40, -30, -30, -20,
-				-30, -40, -40, -50, -50, -40, -40, -30,
-				-30, -40, -40, -50, -50, -40, -40, -30,
-				-30, -40, -40, -50, -50, -40, -40, -30,
-				-30, -40, -40, -50, -50, -40, -40, -30
-			},
-			{
-				-50, -30, -30, -30, -30, -30, -30, -50
-				- 30, -30, 0, 0, 0, 0, -30, -30,
-				-30, -10, 20, 30, 30, 20, -10, -30,
-				-30, -10, 30, 40, 40, 30, -10, -30,
-				-30, -10, 30, 40, 40, 30, -10, -30,
-				-30, -10, 20, 30, 30, 20, -10, -30,
-				-30, -20, -10, 0, 0, -10, -20, -30,
-				-50, -40, -30, -20, -20, -30, -40, -50
-			}
-		},
-	};
-
 	template <Color color>
-	inline Score pieceSquareValue(PieceType piece_type, Square square)
+	inline Score pieceSquareValue(PieceType piece_type, Square square, const Params &params = DefaultParams)
 	{
 		square = Util::relativeSquare<color>(square);
-		return Score(PieceSquareTable[piece_type][0][square], PieceSquareTable[piece_type][1][square]);
+		return Score(params.PieceSquareTable[piece_type][0][square], params.PieceSquareTable[piece_type][1][square]);
 	}
-}
\ No newline at end of file
+}
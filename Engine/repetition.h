@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "move.h"
+#include "types.h"
+
+// The hashes of the positions from the start of the game to the current node of the search
+class RepetitionTable
+{
+public:
+	RepetitionTable() { clear(); }
+
+	void clear()
+	{
+		_entries.clear();
+		std::memset(_filter, 0, sizeof(_filter));
+	}
+
+	// A position reached by an irreversible move can't repeat any earlier position. Null moves are
+	// treated as irreversible too, so that a line with a null move is never scored as a draw.
+	static bool isIrreversible(Move move)
+	{
+		return move.isNull() || move.isCapture() || move.pieceType() == PAWN || move.isCastle();
+	}
+
+	// Adds the position reached by a move
+	void push(u64 hash, bool irreversible)
+	{
+		int reversible_plies = irreversible || _entries.empty() ? 0 : _entries.back().reversible_plies + 1;
+		_entries.push_back({ hash, reversible_plies });
+		++_filter[hash & FilterMask];
+	}
+
+	void pop()
+	{
+		--_filter[_entries.back().hash & FilterMask];
+		_entries.pop_back();
+	}
+
+	// Returns true if the position reached by a move from the last position repeats a position
+	// since the last irreversible move. Only positions with the same side to move are compared.
+	bool isRepetition(u64 hash, bool irreversible) const
+	{
+		if (irreversible || _entries.empty() || !_filter[hash & FilterMask])
+			return false;
+
+		int size = (int)_entries.size();
+		int plies = std::min(_entries.back().reversible_plies + 1, size);
+
+		// Getting back to the same position takes at least four plies
+		for (int distance = 4; distance <= plies; distance += 2)
+		{
+			if (_entries[size - distance].hash == hash)
+				return true;
+		}
+		return false;
+	}
+
+	int size() const
+	{
+		return (int)_entries.size();
+	}
+
+private:
+	struct Entry
+	{
+		u64 hash;
+
+		// The number of moves since the last irreversible move
+		int reversible_plies;
+	};
+
+	std::vector<Entry> _entries;
+
+	// The number of positions in the table by the low bits of the hash, a position is surely not
+	// in the table if its counter is zero
+	const static u64 FilterMask = (1 << 12) - 1;
+	unsigned short _filter[FilterMask + 1];
+};
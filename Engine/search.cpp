@@ -1,131 +1,359 @@
-﻿#include <chrono>
+﻿#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
 #include <iostream>
 #include <thread>
+#include <vector>
 #include "search.h"
 
 namespace Search
 {
-	Search::Search() : _infinite(true), _has_maxdepth(false), _has_movetime(false), _ponder(false), _hash_size(DEFAULT_HASH_TABLE_SIZE)
+	Search::Search() : onBestMove(nullptr), onPrincipalVariation(nullptr), onCurrentMove(nullptr), onSearchInfo(nullptr), onStats(nullptr),
+		_hash_size(DEFAULT_HASH_TABLE_SIZE), _move_history(new MoveSelect::History()), _has_clock{ false, false },
+		_increment{ std::chrono::milliseconds(0), std::chrono::milliseconds(0) }, _moves_to_go(0),
+		_multipv(1), _has_maxdepth(false), _has_maxnodes(false), _has_mate(false), _has_movetime(false), _infinite(true), _ponder(false),
+		_eval_params(&Evaluation::DefaultParams), _own_book(false), _book_best_move(false), _syzygy_probe_limit(Tablebase::MaxPieces),
+		_info_interval(std::chrono::milliseconds(1000)), _currmove_delay(std::chrono::milliseconds(3000))
 	{
 		_resizeHashTable(_hash_size);
 	}
 
-	void Search::_infoThread()
+	void Search::_checkTime()
 	{
-		const static int interval = 10;
+		Timer.nodes_to_check = _Time_Check_Nodes;
 
-		Timer.last_time = std::chrono::steady_clock::now();
-		Timer.elapsed_time = std::chrono::milliseconds(0);
-		Timer.node_count = 0;
-		Timer.last_node_count = 0;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		u64 gap = std::chrono::duration_cast<std::chrono::microseconds>(now - Timer.last_check).count();
+		stats.max_time_check_gap = std::max(stats.max_time_check_gap, gap);
+		Timer.last_check = now;
 
-		while (!_stop)
-		{
-			std::this_thread::sleep_for(std::chrono::milliseconds(interval));
-			_updateNodesPerSec();
-		}
-	}
-
-	void Search::_updateNodesPerSec()
-	{
 		Timer.node_count = stats.alpha_beta_nodes + stats.quiescence_nodes;
-		double node_diff = (double)(Timer.node_count - Timer.last_node_count);
+		Timer.elapsed_time = _time_manager.elapsed();
+		if (Timer.elapsed_time.count() > 0)
+			Timer.nodes_per_sec = (int)(Timer.node_count * 1000 / Timer.elapsed_time.count());
 
-		std::chrono::steady_clock::time_point curr_time = std::chrono::steady_clock::now();
-		auto time_diff = std::chrono::duration_cast<std::chrono::milliseconds>(curr_time - Timer.last_time);
+		if (Timer.elapsed_time - Timer.last_info >= _info_interval)
+			_reportSearchInfo();
+	}
 
-		Timer.nodes_per_sec = (int)(node_diff * (1000.0 / time_diff.count()));
-		Timer.time_left -= time_diff;
-		Timer.elapsed_time += time_diff;
+	void Search::_reportSearchInfo()
+	{
+		Timer.last_info = Timer.elapsed_time;
 
-		Timer.last_node_count = Timer.node_count;
-		Timer.last_time = curr_time;
+		if (onSearchInfo)
+			onSearchInfo(Timer.node_count, Timer.nodes_per_sec, _transposition_table.hashfull(), Timer.elapsed_time);
 	}
 
 	void Search::startSearch(const Board& board)
 	{
-		std::thread search_thread = std::thread(&Search::search, this, board, nullptr, false);
+		// Cleared before the thread starts, so that a stop received right after the go isn't lost
+		_stop.store(false, std::memory_order_relaxed);
+
+		std::thread search_thread = std::thread(&Search::_search, this, board, nullptr, false);
 		search_thread.detach();
 	}
 
 	void Search::search(const Board& board, Move* bestMove, bool quiet)
+	{
+		_stop.store(false, std::memory_order_relaxed);
+		_search(board, bestMove, quiet);
+	}
+
+	void Search::_search(const Board& board, Move* bestMove, bool quiet)
 	{
 		memset(&stats, 0, sizeof(stats));
 
-		Timer.has_time_left = true;
 		if (hasMoveTime())
-			Timer.time_left = getMoveTime();
+			_time_manager.startMoveTime(getMoveTime());
 		else if (hasClock(board.toMove()))
-			Timer.time_left = std::chrono::milliseconds((long long)(getClock(board.toMove()).count() * _ThinkTimePercentage));
+			_time_manager.startClock(getClock(board.toMove()), getIncrement(board.toMove()), getMovesToGo());
 		else
-			Timer.has_time_left = false;
+			_time_manager.startInfinite();
+
+		if (_own_book && _time_manager.hasLimit() && !getPonder() && _search_moves.empty())
+		{
+			Move book_move = _book.probe(board, _book_best_move);
+			if (book_move.isValid())
+			{
+				_stop.store(true, std::memory_order_relaxed);
+
+				if (onBestMove)
+					onBestMove(book_move, Move());
+				if (bestMove)
+					*bestMove = book_move;
+				return;
+			}
+		}
 
-		std::array<std::array<Move, MAX_DEPTH>, MAX_DEPTH> pv;
+		// The PV of the last completed iteration
+		std::array<Move, MAX_DEPTH> pv;
+		pv.fill(Move());
 
 		_transposition_table.clear();
-		_evaluation_table.clear();
-		std::fill(_killer_moves, _killer_moves + MAX_DEPTH, std::make_pair(Move(), Move()));
+
+		SearchStack empty_stack;
+		empty_stack.static_eval = 0;
+		empty_stack.current_move = empty_stack.excluded_move = Move();
+		empty_stack.reduction = 0;
+		empty_stack.killer_moves = std::make_pair(Move(), Move());
+		empty_stack.pv_length = 0;
+		_stack.fill(empty_stack);
+
+		std::fill(&_counter_moves[0][0][0], &_counter_moves[0][0][0] + COLOR_NB * PIECE_TYPE_NB * SQUARE_NB, Move());
+		_move_history->clear();
+
+		_repetitions.clear();
+		for (size_t i = 0; i < _game_history.size(); ++i)
+			_repetitions.push(_game_history[i], i == 0);
+		_repetitions.push(board.hash(), _game_history.empty());
+
+		_initRootMoves(board);
 
 		_passed_maxdepth = false;
 
-		int score;
+		int score = 0;
 		int searched_depth = 0;
 		_can_stop_search = false;
 
-		_stop = false;
-		std::thread info(&Search::_infoThread, this);
-		info.detach();
+		Timer.node_count = 0;
+		Timer.elapsed_time = std::chrono::milliseconds(0);
+		Timer.nodes_per_sec = 0;
+		Timer.last_check = std::chrono::steady_clock::now();
+		Timer.nodes_to_check = _Time_Check_Nodes;
+		Timer.last_info = std::chrono::milliseconds(0);
 
-		for (int depth = 1; _ponder || !hasMaxDepth() || depth <= _maxdepth; ++depth)
+		for (int depth = 1; depth < MAX_DEPTH && (getPonder() || !hasMaxDepth() || depth <= _maxdepth); ++depth)
 		{
 			if (_has_maxdepth && depth > _maxdepth)
 				_passed_maxdepth = true;
 
-			if (board.toMove() == WHITE)
-				score = _alphaBeta<WHITE, true, false>(board, -SCORE_INFINITY, SCORE_INFINITY, depth, 0, &pv[depth]);
-			else
-				score = _alphaBeta<BLACK, true, false>(board, -SCORE_INFINITY, SCORE_INFINITY, depth, 0, &pv[depth]);
-
-			if (score == SCORE_INVALID)
+			u64 iteration_start = stats.alpha_beta_nodes + stats.quiescence_nodes;
+			for (RootMove &root_move : _root_moves)
+			{
+				root_move.previous_score = root_move.score;
+				root_move.previous_nodes = root_move.nodes;
+				root_move.nodes = 0;
+			}
+
+			_pv_count = std::max(1, std::min(_multipv, (int)_root_moves.size()));
+			int iteration_score = _searchRoot(board, depth, pv);
+
+			// Only the node limit stops the first iteration, after a root move was searched
+			if (iteration_score == SCORE_INVALID)
+			{
+				if (!searched_depth)
+					pv = _rootPv();
 				break;
+			}
 
 			++searched_depth;
 
+			// Only the lines keep their score. The next iteration searches them first, then the other moves
+			// by the nodes spent on them.
+			int last_line_score = _lastLineScore(-SCORE_INFINITY);
+			for (RootMove &root_move : _root_moves)
+			{
+				if (root_move.score < last_line_score)
+					root_move.score = -SCORE_INFINITY;
+			}
+
+			std::stable_sort(_root_moves.begin(), _root_moves.end(), [](const RootMove &a, const RootMove &b) {
+				return a.score != b.score ? a.score > b.score : a.nodes > b.nodes;
+			});
+
+			// Without legal moves there is only the mate or stalemate score
+			score = iteration_score;
+			pv.fill(Move());
+			if (!_root_moves.empty())
+			{
+				for (int i = 0; i < _pv_count; ++i)
+					_extendPv(board, _root_moves[i].pv, depth);
+
+				score = _root_moves[0].score;
+				pv = _root_moves[0].pv;
+			}
+
+			_checkTime();
+
 			if (onPrincipalVariation)
-				onPrincipalVariation(pv[depth], depth, score, false);
-			if (onNodeInfo)
-				onNodeInfo(Timer.node_count, Timer.nodes_per_sec);
-			if (onHashfull)
-				onHashfull((int)(_transposition_table.usage() * 1000));
+			{
+				if (_root_moves.empty())
+					onPrincipalVariation(pv, depth, score, EXACT, 1);
+				else
+				{
+					for (int i = 0; i < _pv_count; ++i)
+						onPrincipalVariation(_root_moves[i].pv, depth, _root_moves[i].score, EXACT, i + 1);
+				}
+			}
+
+			_reportSearchInfo();
 
 			_can_stop_search = true;
 
-			_updateNodesPerSec();
+			// With a mate limit, only a mate for the side to move within the limit ends the search
+			if (_isMateScore(score) && (!hasMate() || (score > 0 && (SCORE_MAX_MATE - score + 1) / 2 <= _mate)))
+				break;
+
+			u64 iteration_nodes = stats.alpha_beta_nodes + stats.quiescence_nodes - iteration_start;
+			u64 best_move_nodes = _root_moves.empty() ? iteration_nodes : _root_moves[0].nodes;
+			_time_manager.update(depth, pv[0], score, iteration_nodes ? (double)best_move_nodes / iteration_nodes : 1.0);
 
-			if (SCORE_MIN_MATE <= abs(score) && abs(score) <= SCORE_MAX_MATE)
+			if (!getPonder() && _time_manager.softLimitReached())
 				break;
 		}
 
-		_stop = true;
-
-		Move ponder_move = Move();
-		if (searched_depth >= 2)
-			ponder_move = pv[searched_depth][1];
+		_stop.store(true, std::memory_order_relaxed);
 
 		if (onBestMove)
-			onBestMove(pv[searched_depth][0], ponder_move);
+			onBestMove(pv[0], pv[1]);
 
 		if (bestMove)
-			* bestMove = pv[searched_depth][0];
+			* bestMove = pv[0];
 
 		stats.avg_searched_moves = (float)(stats.alpha_beta_nodes / (double)stats._move_gen_count);
 		if (onStats)
 			onStats(stats);
 	}
 
+	int Search::_searchRoot(const Board &board, int depth, const std::array<Move, MAX_DEPTH> &prev_pv)
+	{
+		// Aspiration windows from the score of the last line to the score of the best line of the
+		// previous iteration
+		int alpha = -SCORE_INFINITY, beta = SCORE_INFINITY;
+		int delta = _Aspiration_Window;
+
+		if (depth >= _Aspiration_Depth && !_root_moves.empty())
+		{
+			int best = _root_moves[0].previous_score;
+			int last = _root_moves[_pv_count - 1].previous_score;
+			if (last != -SCORE_INFINITY && !_isMateScore(best) && !_isMateScore(last))
+			{
+				alpha = std::max(last - delta, (int)-SCORE_INFINITY);
+				beta = std::min(best + delta, (int)SCORE_INFINITY);
+			}
+		}
+
+		_root_order.clear();
+		for (const RootMove &root_move : _root_moves)
+			_root_order.push_back(root_move.move);
+
+		while (true)
+		{
+			for (RootMove &root_move : _root_moves)
+				root_move.score = -SCORE_INFINITY;
+
+			int score;
+			if (board.toMove() == WHITE)
+				score = _alphaBeta<WHITE, true, false>(board, alpha, beta, depth, 0);
+			else
+				score = _alphaBeta<BLACK, true, false>(board, alpha, beta, depth, 0);
+
+			// Every line has to be inside the window
+			if (score == SCORE_INVALID || _root_moves.empty() || (_lastLineScore(alpha) > alpha && score < beta))
+				return score;
+
+			++stats.aspiration_research_count;
+			delta += delta / 2;
+
+			if (score >= beta)
+			{
+				if (onPrincipalVariation)
+					onPrincipalVariation(_rootPv(), depth, score, LOWER_BOUND, 1);
+
+				// The re-search starts with the move that failed high
+				auto it = std::find(_root_order.begin(), _root_order.end(), _pvRow(0)[0]);
+				if (it != _root_order.end())
+					std::rotate(_root_order.begin(), it, it + 1);
+
+				beta = std::min(score + delta, (int)SCORE_INFINITY);
+			}
+			else
+			{
+				if (score <= alpha)
+				{
+					if (onPrincipalVariation)
+						onPrincipalVariation(prev_pv, depth, score, UPPER_BOUND, 1);
+
+					beta = (alpha + beta) / 2;
+				}
+
+				alpha = std::max(alpha - delta, (int)-SCORE_INFINITY);
+			}
+		}
+	}
+
+	// Generates the legal moves in the order of the move selector, the initial order of the root moves
+	template <Color toMove>
+	static void _genLegalMoves(const Board &board, std::vector<Move> &legal_moves)
+	{
+		MoveSelect::MoveSelector<toMove, false> mg(board);
+		for (; !mg.end(); mg.next())
+		{
+			Board board_copy = board;
+			if (board_copy.makeMove(mg.curr()))
+				legal_moves.push_back(mg.curr());
+		}
+	}
+
+	void Search::_initRootMoves(const Board &board)
+	{
+		std::vector<Move> moves;
+		if (board.toMove() == WHITE)
+			_genLegalMoves<WHITE>(board, moves);
+		else
+			_genLegalMoves<BLACK>(board, moves);
+
+		if (Util::popCount(board.occupied()) <= _syzygy_probe_limit)
+			Tablebase::filterRootMoves(board, moves);
+
+		_root_moves.clear();
+		for (Move move : moves)
+		{
+			if (!_isSearchMove(move))
+				continue;
+
+			RootMove root_move;
+			root_move.move = move;
+			root_move.score = root_move.previous_score = -SCORE_INFINITY;
+			root_move.nodes = root_move.previous_nodes = 0;
+			root_move.pv.fill(Move());
+			_root_moves.push_back(root_move);
+		}
+
+		_pv_count = 1;
+	}
+
+	Search::RootMove *Search::_findRootMove(Move move)
+	{
+		for (RootMove &root_move : _root_moves)
+		{
+			if (root_move.move == move)
+				return &root_move;
+		}
+		return nullptr;
+	}
+
+	int Search::_lastLineScore(int score)
+	{
+		int scores[MAX_MOVES];
+		int count = 0;
+		for (const RootMove &root_move : _root_moves)
+		{
+			if (root_move.score != -SCORE_INFINITY)
+				scores[count++] = root_move.score;
+		}
+
+		if (count < _pv_count)
+			return score;
+
+		std::nth_element(scores, scores + _pv_count - 1, scores + count, std::greater<int>());
+		return scores[_pv_count - 1];
+	}
+
 	void Search::stopSearch()
 	{
-		_stop = true;
+		_stop.store(true, std::memory_order_relaxed);
 	}
 
 	bool Search::hasClock(Color color)
@@ -149,6 +377,26 @@ namespace Search
 		_has_clock[color] = false;
 	}
 
+	std::chrono::milliseconds Search::getIncrement(Color color)
+	{
+		return _increment[color];
+	}
+
+	void Search::setIncrement(Color color, std::chrono::milliseconds increment)
+	{
+		_increment[color] = increment;
+	}
+
+	int Search::getMovesToGo()
+	{
+		return _moves_to_go;
+	}
+
+	void Search::setMovesToGo(int moves_to_go)
+	{
+		_moves_to_go = moves_to_go;
+	}
+
 	bool Search::hasMaxDepth()
 	{
 		return _has_maxdepth;
@@ -172,6 +420,61 @@ namespace Search
 		_has_maxdepth = false;
 	}
 
+	bool Search::hasMaxNodes()
+	{
+		return _has_maxnodes;
+	}
+
+	u64 Search::getMaxNodes()
+	{
+		return _maxnodes;
+	}
+
+	void Search::setMaxNodes(u64 maxnodes)
+	{
+		_has_maxnodes = true;
+		_maxnodes = maxnodes;
+		_infinite = false;
+	}
+
+	void Search::unsetMaxNodes()
+	{
+		_has_maxnodes = false;
+	}
+
+	bool Search::hasMate()
+	{
+		return _has_mate;
+	}
+
+	int Search::getMate()
+	{
+		return _mate;
+	}
+
+	void Search::setMate(int moves)
+	{
+		ASSERT(moves > 0);
+		_has_mate = true;
+		_mate = moves;
+		_infinite = false;
+	}
+
+	void Search::unsetMate()
+	{
+		_has_mate = false;
+	}
+
+	const std::vector<Move> &Search::getSearchMoves()
+	{
+		return _search_moves;
+	}
+
+	void Search::setSearchMoves(const std::vector<Move> &moves)
+	{
+		_search_moves = moves;
+	}
+
 	bool Search::hasMoveTime()
 	{
 		return _has_movetime;
@@ -206,14 +509,35 @@ namespace Search
 		_has_movetime = _has_maxdepth = !_infinite;
 	}
 
+	int Search::getMultiPv()
+	{
+		return _multipv;
+	}
+
+	void Search::setMultiPv(int multipv)
+	{
+		ASSERT(multipv >= 1);
+		_multipv = multipv;
+	}
+
 	bool Search::getPonder()
 	{
-		return _ponder;
+		return _ponder.load(std::memory_order_relaxed);
 	}
 
 	void Search::setPonder(bool ponder)
 	{
-		_ponder = ponder;
+		_ponder.store(ponder, std::memory_order_relaxed);
+	}
+
+	const Evaluation::Params &Search::getEvalParams()
+	{
+		return *_eval_params;
+	}
+
+	void Search::setEvalParams(const Evaluation::Params &params)
+	{
+		_eval_params = &params;
 	}
 
 	size_t Search::getHashSize()
@@ -227,56 +551,240 @@ namespace Search
 		_resizeHashTable(_hash_size);
 	}
 
+	bool Search::loadBook(const std::string &path)
+	{
+		return _book.open(path);
+	}
+
+	bool Search::getOwnBook()
+	{
+		return _own_book;
+	}
+
+	void Search::setOwnBook(bool own_book)
+	{
+		_own_book = own_book;
+	}
+
+	bool Search::getBookBestMove()
+	{
+		return _book_best_move;
+	}
+
+	void Search::setBookBestMove(bool best)
+	{
+		_book_best_move = best;
+	}
+
+	int Search::getSyzygyProbeLimit()
+	{
+		return _syzygy_probe_limit;
+	}
+
+	void Search::setSyzygyProbeLimit(int limit)
+	{
+		_syzygy_probe_limit = limit;
+	}
+
+	std::chrono::milliseconds Search::getInfoInterval()
+	{
+		return _info_interval;
+	}
+
+	void Search::setInfoInterval(std::chrono::milliseconds interval)
+	{
+		_info_interval = interval;
+	}
+
+	std::chrono::milliseconds Search::getCurrmoveDelay()
+	{
+		return _currmove_delay;
+	}
+
+	void Search::setCurrmoveDelay(std::chrono::milliseconds delay)
+	{
+		_currmove_delay = delay;
+	}
+
+	void Search::setGameHistory(const std::vector<u64> &history)
+	{
+		_game_history = history;
+	}
+
 	const Search::Stats& Search::getStats()
 	{
 		return stats;
 	
 	}
 
-	bool Search::_isRepetition(u64 hash, int ply)
+	bool Search::_isMateScore(int score)
 	{
-		for (int i = 0; i < ply; i += 2)
-		{
-			if (_history[i] == hash)
-				return true;
-		}
-		return false;
+		return SCORE_MIN_MATE <= abs(score) && abs(score) <= SCORE_MAX_MATE;
 	}
 
-	bool Search::_isMateScore(int score)
+	bool Search::_isTablebaseScore(int score)
 	{
-		return SCORE_MIN_MATE <= abs(score) && abs(score) <= SCORE_MAX_MATE;
+		return SCORE_TABLEBASE_WIN - MAX_DEPTH <= abs(score) && abs(score) <= SCORE_TABLEBASE_WIN;
+	}
+
+	int Search::_scoreToTT(int score, int ply)
+	{
+		if (!_isTablebaseScore(score))
+			return score;
+		return score > 0 ? score + ply : score - ply;
+	}
+
+	int Search::_scoreFromTT(int score, int ply)
+	{
+		if (!_isTablebaseScore(score))
+			return score;
+		return score > 0 ? score - ply : score + ply;
+	}
+
+	bool Search::_isSearchMove(Move move)
+	{
+		if (_search_moves.empty())
+			return true;
+
+		// Compared by squares and promotion, since the flags of parsed moves may differ from the generated ones
+		return std::any_of(_search_moves.begin(), _search_moves.end(), [move](Move m) {
+			return m.from() == move.from() && m.to() == move.to() && m.promotion() == move.promotion();
+		});
 	}
 
 	int Search::_razorMargin(int depth)
 	{
 		return (90 * (depth - 1) + 18);
 	}
+
+	void Search::_updatePv(int ply, Move move)
+	{
+		int length = std::min(_stack[ply + 1].pv_length, MAX_DEPTH - ply - 1);
+		Move *row = _pvRow(ply);
+
+		row[0] = move;
+		std::copy(_pvRow(ply + 1), _pvRow(ply + 1) + length, row + 1);
+		_stack[ply].pv_length = length + 1;
+	}
+
+	std::array<Move, MAX_DEPTH> Search::_rootPv()
+	{
+		std::array<Move, MAX_DEPTH> pv;
+		pv.fill(Move());
+		std::copy(_pvRow(0), _pvRow(0) + _stack[0].pv_length, pv.begin());
+		return pv;
+	}
+
+	template <Color toMove>
+	static bool _isLegal(const Board &board, Move move)
+	{
+		Move moves[MAX_MOVES];
+		int move_count;
+
+		MoveGen::genMoves<toMove, false>(board, moves, move_count);
+		if (std::find(moves, moves + move_count, move) == moves + move_count)
+			return false;
+
+		Board board_copy = board;
+		return board_copy.makeMove(move);
+	}
+
+	void Search::_extendPv(const Board &board, std::array<Move, MAX_DEPTH> &pv, int depth)
+	{
+		Board curr = board;
+		std::vector<u64> hashes = { curr.hash() };
+
+		int length = 0;
+		for (; length < MAX_DEPTH && pv[length].isValid(); ++length)
+		{
+			curr.makeMove(pv[length]);
+			hashes.push_back(curr.hash());
+		}
+
+		while (length < std::min(depth, MAX_DEPTH))
+		{
+			TranspositionTable::Entry entry;
+			if (!_transposition_table.probeEntry(curr.hash(), entry) || !entry.move.isValid())
+				break;
+
+			bool legal = curr.toMove() == WHITE ? _isLegal<WHITE>(curr, entry.move) : _isLegal<BLACK>(curr, entry.move);
+			if (!legal)
+				break;
+
+			curr.makeMove(entry.move);
+
+			// Stop at a repetition, the hash moves would go around in a cycle
+			if (std::find(hashes.begin(), hashes.end(), curr.hash()) != hashes.end())
+				break;
+
+			hashes.push_back(curr.hash());
+			pv[length++] = entry.move;
+		}
+	}
+
+	bool Search::_initReductions()
+	{
+		for (int depth = 1; depth < MAX_DEPTH; ++depth)
+		{
+			for (int move_num = 1; move_num < MAX_MOVES; ++move_num)
+				_Reductions[depth][move_num] = (int)(_LMR_Base + std::log(depth) * std::log(move_num) / _LMR_Divisor);
+		}
+		return true;
+	}
 	bool Search::_passedMaxdepth()
 	{
 		return _has_maxdepth && _passed_maxdepth;
 	}
+	bool Search::_passedMaxNodes()
+	{
+		return _has_maxnodes && stats.alpha_beta_nodes + stats.quiescence_nodes >= _maxnodes;
+	}
 	bool Search::_timeOut()
 	{
-		return Timer.has_time_left && Timer.time_left <= std::chrono::milliseconds(0);
+		return _time_manager.hardLimitReached(Timer.elapsed_time);
 	}
 	bool Search::_shouldStopSearch()
 	{
-		return _can_stop_search && (
-			_stop
-			|| !_ponder && _passedMaxdepth()
-			|| _timeOut());
+		// The node limit also ends the first iteration, once the root has a best move
+		if (!_can_stop_search)
+			return !getPonder() && _passedMaxNodes() && _stack[0].pv_length > 0;
+
+		return _stop.load(std::memory_order_relaxed)
+			|| (!getPonder() && _passedMaxdepth())
+			|| (!getPonder() && _passedMaxNodes())
+			|| _timeOut();
 	}
 
 	void Search::_resizeHashTable(size_t size)
 	{
-		_transposition_table.resize((size_t)(size * 0.75));
-		_evaluation_table.resize((size_t)(size * 0.25));
+		_transposition_table.resize(size);
 	}
 
 	const int Search::_RFutility_Depth = 3;
 	const int Search::_RFutility_Param = 120;
+	const int Search::_Futility_Depth = 3;
+	const int Search::_Futility_Margin = 150;
+	const int Search::_LMP_Depth = 3;
+	const int Search::_LMP_MoveCount = 3;
+	const int Search::_SEE_Depth = 4;
+	const int Search::_SEE_Capture_Margin = 100;
+	const int Search::_SEE_Quiet_Margin = 60;
+	const int Search::_ProbCut_Depth = 5;
+	const int Search::_ProbCut_Margin = 150;
+	const int Search::_ProbCut_Reduction = 4;
 	const int Search::_IID_Depth = 6;
-	const int Search::_IID_Reduction = 4;
-	const double Search::_ThinkTimePercentage = 0.025;
+	const int Search::_IID_Reduction = 1;
+	const int Search::_Aspiration_Depth = 5;
+	const int Search::_Aspiration_Window = 25;
+	const int Search::_History_Max_Bonus = 400;
+	const int Search::_Time_Check_Nodes = 1024;
+	const int Search::_LMR_Depth = 3;
+	const int Search::_Singular_Depth = 8;
+	const int Search::_Singular_Margin = 2;
+	const int Search::_LMR_MoveCount = 3;
+	const double Search::_LMR_Base = 0.75;
+	const double Search::_LMR_Divisor = 2.25;
+
+	int Search::_Reductions[MAX_DEPTH][MAX_MOVES];
+	const bool Search::_Reductions_Initialized = _initReductions();
 }
\ No newline at end of file
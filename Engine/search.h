@@ -1,14 +1,21 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include "board.h"
+#include "book.h"
 #include "config.h"
 #include "evaluation.h"
-#include "evaluation_table.h"
+#include "history.h"
 #include "movegen.h"
 #include "moveselect.h"
+#include "repetition.h"
+#include "tablebase.h"
+#include "time_manager.h"
 #include "transposition_table.h"
 #include "types.h"
 
@@ -31,6 +38,21 @@ namespace Search
 			u64 killer_move_cutoffs;
 			u64 hash_score_returned;
 			u64 pv_search_research_count;
+			u64 lmr_reductions;
+			u64 lmr_research_count;
+			u64 aspiration_research_count;
+			u64 singular_extensions;
+			u64 multi_cut_prunes;
+			u64 probcut_prunes;
+			u64 iid_reductions;
+			u64 late_move_prunes;
+			u64 futility_prunes;
+			u64 see_prunes;
+			u64 draws_detected;
+			u64 tablebase_hits;
+
+			// The longest time between two clock checks in microseconds, which bounds the stop latency
+			u64 max_time_check_gap;
 			float avg_searched_moves;
 
 			u64 _move_gen_count;
@@ -47,11 +69,34 @@ namespace Search
 		void setClock(Color color, std::chrono::milliseconds clock);
 		void unsetClock(Color color);
 
+		// The increment per move, 0 if not set
+		std::chrono::milliseconds getIncrement(Color color);
+		void setIncrement(Color color, std::chrono::milliseconds increment);
+
+		// The number of moves to the next time control, 0 if unknown
+		int getMovesToGo();
+		void setMovesToGo(int moves_to_go);
+
 		bool hasMaxDepth();
 		int getMaxDepth();
 		void setMaxDepth(int maxdepth);
 		void unsetMaxDepth();
 
+		bool hasMaxNodes();
+		u64 getMaxNodes();
+		void setMaxNodes(u64 maxnodes);
+		void unsetMaxNodes();
+
+		// Search for a mate in the given number of moves, the search stops when one is found
+		bool hasMate();
+		int getMate();
+		void setMate(int moves);
+		void unsetMate();
+
+		// Only these moves are searched at the root, all of them if empty
+		const std::vector<Move> &getSearchMoves();
+		void setSearchMoves(const std::vector<Move> &moves);
+
 		bool hasMoveTime();
 		std::chrono::milliseconds getMoveTime();
 		void setMoveTime(std::chrono::milliseconds movetime);
@@ -60,58 +105,214 @@ namespace Search
 		bool isInfinite();
 		void setInfinite(bool infinite);
 
+		// The number of best moves searched and reported, each with its own principal variation
+		int getMultiPv();
+		void setMultiPv(int multipv);
+
 		bool getPonder();
 		void setPonder(bool ponder);
 
+		// The weights of the evaluation, they must stay alive as long as the search uses them
+		const Evaluation::Params &getEvalParams();
+		void setEvalParams(const Evaluation::Params &params);
+
 		// The size of the hash table in megabytes
 		size_t getHashSize();
 		void setHashSize(size_t size);
 
+		// Book moves are played without searching, but only if there is a time limit and the
+		// search is not pondering. Returns false if the book can't be loaded.
+		bool loadBook(const std::string &path);
+		bool getOwnBook();
+		void setOwnBook(bool own_book);
+
+		// Play the book move with the highest weight instead of a random one by weight
+		bool getBookBestMove();
+		void setBookBestMove(bool best);
+
+		// Positions with at most this many pieces are looked up in the Syzygy tablebases, 0 disables it
+		int getSyzygyProbeLimit();
+		void setSyzygyProbeLimit(int limit);
+
+		// The least time between two onSearchInfo reports within an iteration
+		std::chrono::milliseconds getInfoInterval();
+		void setInfoInterval(std::chrono::milliseconds interval);
+
+		// The time the search runs before reporting onCurrentMove
+		std::chrono::milliseconds getCurrmoveDelay();
+		void setCurrmoveDelay(std::chrono::milliseconds delay);
+
+		// The hashes of the positions of the game before the searched position, since the last
+		// irreversible move, used to detect repetitions of the game history
+		void setGameHistory(const std::vector<u64> &history);
+
 		const Stats& getStats();
 
 		void (*onBestMove)(Move move, Move ponder_move);
-		void (*onPrincipalVariation)(const std::array<Move, MAX_DEPTH>& pv, int depth, int score, bool mate);
-		void (*onCurrentMove)(Move move, int pos);
-		void (*onNodeInfo)(u64 node_count, u64 nodes_per_sec);
-		void (*onHashfull)(int permill);
+		void (*onPrincipalVariation)(const std::array<Move, MAX_DEPTH>& pv, int depth, int score, ScoreType score_type, int multipv);
+		// Only reported once the search has run for the currmove delay. The nodes are those spent on
+		// the move in the previous iteration.
+		void (*onCurrentMove)(Move move, int pos, u64 nodes);
+		// Reported after each iteration and at most every info interval in between
+		void (*onSearchInfo)(u64 node_count, u64 nodes_per_sec, int hashfull, std::chrono::milliseconds time);
 		void (*onStats)(const Stats &stats);
 
 	private:
 		template <Color toMove, bool pvNode, bool nullMoveAllowed>
-		int _alphaBeta(const Board& board, int alpha, int beta, int depthleft, int ply, std::array<Move, MAX_DEPTH>* pv);
+		int _alphaBeta(const Board& board, int alpha, int beta, int depthleft, int ply);
 
 		template <Color toMove>
 		int _quiescence(const Board& board, int alpha, int beta);
 
-		void _updateNodesPerSec();
-		void _infoThread();
+		template <Color toMove>
+		int _evaluate(const Board& board);
+
+		// Updates the elapsed time and the node speed, called every _Time_Check_Nodes nodes
+		void _checkTime();
+
+		void _reportSearchInfo();
 
-		bool _isRepetition(u64 hash, int ply);
 		bool _isMateScore(int score);
+
+		// Tablebase scores count the plies from the root, the transposition table keeps them
+		// relative to the node like mate scores so they stay valid at any ply
+		bool _isTablebaseScore(int score);
+		int _scoreToTT(int score, int ply);
+		int _scoreFromTT(int score, int ply);
+		bool _isSearchMove(Move move);
 		int _razorMargin(int depth);
 
+		static bool _initReductions();
+
 		bool _passedMaxdepth();
+		bool _passedMaxNodes();
 		bool _timeOut();
 		bool _shouldStopSearch();
 
 		void _resizeHashTable(size_t size);
 
 		TranspositionTable _transposition_table;
-		EvaluationTable _evaluation_table;
 
 		size_t _hash_size;
 
-		std::pair<Move, Move> _killer_moves[MAX_DEPTH];
-		std::array<u64, MAX_DEPTH> _history;
+		// Indexed by the color, piece and destination of the move it refutes
+		Move _counter_moves[COLOR_NB][PIECE_TYPE_NB][SQUARE_NB];
+
+		std::unique_ptr<MoveSelect::History> _move_history;
+
+		// Positions of the game before the searched position, since the last irreversible move
+		std::vector<u64> _game_history;
+
+		// The game history followed by the positions on the path from the root to the current node
+		RepetitionTable _repetitions;
+
+		// The state of the search at each ply
+		struct SearchStack
+		{
+			int static_eval;
+
+			// The move being searched, and the reduction applied to it
+			Move current_move;
+			int reduction;
+
+			// The move skipped by the singular extension search
+			Move excluded_move;
+
+			std::pair<Move, Move> killer_moves;
+
+			// The length of the principal variation starting at this ply, stored in the PV table
+			int pv_length;
+		};
+
+		std::array<SearchStack, MAX_DEPTH> _stack;
+
+		// Triangular PV table, the row of a ply holds the principal variation starting at that ply,
+		// which can't be longer than MAX_DEPTH - ply moves
+		Move _pv_table[MAX_DEPTH * (MAX_DEPTH + 1) / 2];
+
+		Move *_pvRow(int ply) { return _pv_table + ply * MAX_DEPTH - ply * (ply - 1) / 2; }
+
+		struct RootMove
+		{
+			Move move;
+
+			// The score of the move in the current and in the previous iteration if it is one of
+			// the MultiPV lines, -SCORE_INFINITY otherwise
+			int score;
+			int previous_score;
+
+			// The PV found with the score
+			std::array<Move, MAX_DEPTH> pv;
+
+			// Nodes spent on the move in the current and in the previous iteration
+			u64 nodes;
+			u64 previous_nodes;
+		};
+
+		// The legal root moves (restricted to the search moves), kept across iterations. They are sorted
+		// after each iteration by score, and the moves without a score by the nodes spent on them.
+		std::vector<RootMove> _root_moves;
+
+		// The number of lines searched, MultiPV limited to the number of root moves
+		int _pv_count;
+
+		// The order in which the root is searched in the current iteration
+		std::vector<Move> _root_order;
+
+		// The iterative deepening loop, expects the stop flag to be cleared by the caller
+		void _search(const Board& board, Move* bestMove, bool quiet);
+
+		void _initRootMoves(const Board &board);
+
+		// Returns the root move, nullptr if the move isn't searched
+		RootMove *_findRootMove(Move move);
+
+		// Returns the score of the last of the _pv_count best lines of the current iteration, or
+		// the given score while fewer lines have a score
+		int _lastLineScore(int score);
+
+		// Searches the root with aspiration windows around the scores of the previous iteration,
+		// returns the best score
+		int _searchRoot(const Board &board, int depth, const std::array<Move, MAX_DEPTH> &prev_pv);
+
+		// Searches the position after a root move as one of the MultiPV lines, from the side of the root.
+		// Returns -SCORE_INVALID if the search was stopped, like the negated child search.
+		template <Color toMove>
+		int _searchLine(const Board& board, const RootMove &root_move, int alpha, int beta, int depth, bool reduced, int best_score);
+
+		// Sets the PV of the ply to the move followed by the PV of the next ply
+		void _updatePv(int ply, Move move);
+
+		// Returns the PV of the root, terminated by an invalid move if shorter than MAX_DEPTH
+		std::array<Move, MAX_DEPTH> _rootPv();
+
+		// Appends the hash moves following the PV until it is depth moves long. The PV gets truncated
+		// where a hash cutoff ended the search of the line.
+		void _extendPv(const Board &board, std::array<Move, MAX_DEPTH> &pv, int depth);
 
 		std::thread _search_thrd;
 
 		bool _has_clock[COLOR_NB];
 		std::chrono::milliseconds _clock[COLOR_NB];
+		std::chrono::milliseconds _increment[COLOR_NB];
+		int _moves_to_go;
+
+		TimeManager _time_manager;
+
+		// The number of principal variations searched and reported, the best moves first
+		int _multipv;
 
 		int _maxdepth;
 		bool _has_maxdepth;
 
+		u64 _maxnodes;
+		bool _has_maxnodes;
+
+		int _mate;
+		bool _has_mate;
+
+		std::vector<Move> _search_moves;
+
 		// The exact length of the search
 		bool _has_movetime;
 		std::chrono::milliseconds _movetime;
@@ -119,8 +320,19 @@ namespace Search
 		// If true, the search doesn't stop unless manually terminated
 		bool _infinite;
 
-		bool _stop;
-		bool _ponder;
+		// Set from the UCI thread while searching
+		std::atomic<bool> _stop;
+		std::atomic<bool> _ponder;
+		const Evaluation::Params *_eval_params;
+
+		Book _book;
+		bool _own_book;
+		bool _book_best_move;
+
+		int _syzygy_probe_limit;
+
+		std::chrono::milliseconds _info_interval;
+		std::chrono::milliseconds _currmove_delay;
 
 		// This is needed when pondering, when the search is infinite. If the opponent makes the expected move,
 		// we have to switch from pondering to normal search, and consequently stop searching if maxdepth is passed
@@ -131,34 +343,67 @@ namespace Search
 
 		struct
 		{
-			u64 last_node_count;
 			u64 node_count;
-			std::chrono::steady_clock::time_point last_time;
 			std::chrono::milliseconds elapsed_time;
 			int nodes_per_sec;
-			bool has_time_left;
-			std::chrono::milliseconds time_left;
+			std::chrono::steady_clock::time_point last_check;
+			int nodes_to_check;
+			std::chrono::milliseconds last_info;
 		} Timer;
 
+		// Late move reductions indexed by [depth][move number], filled once at static initialization, since
+		// the searches of a match run in parallel
+		static int _Reductions[MAX_DEPTH][MAX_MOVES];
+		const static bool _Reductions_Initialized;
+
 		// Search parameters
 		const static int _RFutility_Depth;
 		const static int _RFutility_Param;
+		const static int _Futility_Depth;
+		const static int _Futility_Margin;
+		const static int _LMP_Depth;
+		const static int _LMP_MoveCount;
+		const static int _SEE_Depth;
+		const static int _SEE_Capture_Margin;
+		const static int _SEE_Quiet_Margin;
+		const static int _ProbCut_Depth;
+		const static int _ProbCut_Margin;
+		const static int _ProbCut_Reduction;
 		const static int _IID_Depth;
 		const static int _IID_Reduction;
-		const static double _ThinkTimePercentage;
+		const static int _Aspiration_Depth;
+		const static int _Aspiration_Window;
+		const static int _History_Max_Bonus;
+		const static int _Time_Check_Nodes;
+		const static int _LMR_Depth;
+		const static int _Singular_Depth;
+		const static int _Singular_Margin;
+		const static int _LMR_MoveCount;
+		const static double _LMR_Base;
+		const static double _LMR_Divisor;
 	};
 
+	template <Color toMove>
+	int Search::_evaluate(const Board& board)
+	{
+		return Evaluation::evaluate<toMove>(board, *_eval_params);
+	}
+
 	template <Color toMove>
 	int Search::_quiescence(const Board& board, int alpha, int beta)
 	{
+		if (--Timer.nodes_to_check <= 0)
+			_checkTime();
+
+		if (_shouldStopSearch())
+			return SCORE_INVALID;
+
 		++stats.quiescence_nodes;
 
-		int stand_pat = _evaluation_table.probe(board.hash(), alpha, beta);
-		if (stand_pat != SCORE_INVALID)
-		{
-			stand_pat = Evaluation::evaluate<toMove>(board);
-			_evaluation_table.insert(board.hash(), stand_pat, EXACT);
-		}
+		if (board.isDraw())
+			return SCORE_DRAW;
+
+		int stand_pat = _evaluate<toMove>(board);
 
 		if (stand_pat >= beta)
 			return beta;
@@ -169,8 +414,6 @@ namespace Search
 		if (alpha < stand_pat)
 			alpha = stand_pat;
 
-		int alpha_orig = alpha;
-
 		MoveSelect::MoveSelector<toMove, true> mg(board, Move());
 		for (int i = 1; !mg.end(); ++i, mg.next())
 		{
@@ -185,67 +428,134 @@ namespace Search
 				continue;
 
 			int score = -_quiescence<~toMove>(board_copy, -beta, -alpha);
+			if (score == -SCORE_INVALID)
+				return SCORE_INVALID;
+
 			if (score >= beta)
 			{
 				++stats.quiescence_cutoffs;
-				_evaluation_table.insert(board.hash(), score, LOWER_BOUND);
 				return beta;
 			}
 			if (score > alpha)
 				alpha = score;
 		}
 
-		if (alpha > alpha_orig)
-			_evaluation_table.insert(board.hash(), alpha, EXACT);
-		else
-			_evaluation_table.insert(board.hash(), alpha, UPPER_BOUND);
-
 		return alpha;
 	}
 
+	// The window is narrowed around the score of the line in the previous iteration. Except for the
+	// first root move, the lines are searched one ply shallower and only searched to the full depth
+	// if they become the best line.
+	template <Color toMove>
+	int Search::_searchLine(const Board& board, const RootMove &root_move, int alpha, int beta, int depth, bool reduced, int best_score)
+	{
+		int low = alpha, high = beta;
+		int delta = _Aspiration_Window;
+		reduced = reduced && depth > 1;
+
+		if (depth >= _Aspiration_Depth && root_move.previous_score != -SCORE_INFINITY && !_isMateScore(root_move.previous_score))
+		{
+			low = std::max(alpha, root_move.previous_score - delta);
+			high = std::min(beta, root_move.previous_score + delta);
+		}
+
+		while (true)
+		{
+			int score = -_alphaBeta<toMove, true, false>(board, -high, -low, depth - reduced, 1);
+			if (score == -SCORE_INVALID)
+				return score;
+
+			if (reduced && score > best_score)
+			{
+				reduced = false;
+				continue;
+			}
+
+			delta += delta / 2;
+
+			if (score <= low && low > alpha)
+				low = std::max(alpha, low - delta);
+			else if (score >= high && high < beta)
+				high = std::min(beta, high + delta);
+			else
+				return score;
+		}
+	}
+
 	template <Color toMove, bool pvNode, bool nullMoveAllowed>
-	int Search::_alphaBeta(const Board & board, int alpha, int beta, int depthleft, int ply, std::array<Move, MAX_DEPTH>* pv)
+	int Search::_alphaBeta(const Board & board, int alpha, int beta, int depthleft, int ply)
 	{
 		ASSERT(depthleft >= 0);
 
+		SearchStack &ss = _stack[ply];
+
+		if (pvNode)
+			ss.pv_length = 0;
+
+		if (--Timer.nodes_to_check <= 0)
+			_checkTime();
+
 		if (_shouldStopSearch())
 			return SCORE_INVALID;
 
 		++stats.alpha_beta_nodes;
 
-		if (stats.alpha_beta_nodes % 30000 == 0)
+		if (ply >= MAX_DEPTH - 1)
+			return _evaluate<toMove>(board);
+
+		// Draw by the fifty-move rule or insufficient material. A position in check is searched, since
+		// the move reaching the fifty-move limit may have been checkmate, which takes precedence.
+		if (ply && board.isDraw() && !board.isInCheck(toMove))
 		{
-			if (onNodeInfo)
-				onNodeInfo(Timer.node_count, Timer.nodes_per_sec);
-			if (onHashfull)
-				onHashfull((int)(_transposition_table.usage() * 1000));
+			++stats.draws_detected;
+			return SCORE_DRAW;
 		}
 
-		_history[ply] = board.hash();
+		// The result is only exact right after a capture or a pawn move, the root moves are filtered
+		// by the distance to zeroing instead
+		Tablebase::Wdl wdl;
+		if (ply && !ss.excluded_move.isValid() && board.halfmoveClock() == 0
+			&& Util::popCount(board.occupied()) <= _syzygy_probe_limit && Tablebase::probeWdl(board, wdl))
+		{
+			++stats.tablebase_hits;
+			return wdl == Tablebase::WDL_WIN ? SCORE_TABLEBASE_WIN - ply
+				: wdl == Tablebase::WDL_LOSS ? -SCORE_TABLEBASE_WIN + ply : SCORE_DRAW;
+		}
 
 		Move hash_move = Move();
+		Move prev_move = ply ? _stack[ply - 1].current_move : Move();
+		Move excluded_move = ss.excluded_move;
 
-		// Transposition table lookup
-		auto hash = _transposition_table.probe(board.hash(), depthleft, alpha, beta);
-		if (hash.first == alpha || hash.first == beta)
-		{
-			ASSERT(ply);
-			++stats.hash_score_returned;
-			return hash.first;
-		}
-		else if (hash.second.isValid())
+		// Transposition table lookup, skipped by the singular extension search, which
+		// would find the result of the full search of the same position
+		TranspositionTable::Entry entry;
+		bool has_entry = !excluded_move.isValid() && _transposition_table.probeEntry(board.hash(), entry);
+
+		if (has_entry)
 		{
-			ASSERT(board.pieceAt(hash.second.from()) != NO_PIECE);
-			hash_move = hash.second;
+			entry.score = _scoreFromTT(entry.score, ply);
+			int hash_score = _transposition_table.cutoffScore(entry, depthleft, alpha, beta);
+			if (ply && hash_score != SCORE_INVALID)
+			{
+				++stats.hash_score_returned;
+				return hash_score;
+			}
+			else if (entry.move.isValid())
+			{
+				ASSERT(board.pieceAt(entry.move.from()) != NO_PIECE);
+				hash_move = entry.move;
+			}
 		}
 
 		if (depthleft == 0)
 			return _quiescence<toMove>(board, alpha, beta);
 
-		int eval = Evaluation::evaluate<toMove>(board);
+		int eval = _evaluate<toMove>(board);
+		ss.static_eval = eval;
 
 		// Reverse futility pruning
 		if (!pvNode
+			&& !excluded_move.isValid()
 			&& depthleft <= _RFutility_Depth
 			&& !board.isInCheck(toMove)
 			&& std::abs(alpha) < SCORE_MIN_MATE && std::abs(beta) < SCORE_MIN_MATE
@@ -257,27 +567,82 @@ namespace Search
 
 		// Dynamic null move pruning
 		if (nullMoveAllowed
+			&& !excluded_move.isValid()
 			&& depthleft >= 4
 			&& !board.isInCheck(toMove)
 			&& board.allowNullMove())
 		{
+			_transposition_table.prefetch(board.hashAfter(Move::nullMove()));
+
 			Board board_copy = board;
 			board_copy.makeMove(Move::nullMove());
+			ss.current_move = Move::nullMove();
+			ss.reduction = 0;
+
+			_repetitions.push(board_copy.hash(), true);
+			int score = -_alphaBeta<~toMove, false, false>(board_copy, -beta, -beta + 1, depthleft - 3, ply + 1);
+			_repetitions.pop();
 
-			int score = -_alphaBeta<~toMove, false, false>(board_copy, -beta, -beta + 1, depthleft - 3, ply + 1, nullptr);
 			if (score >= beta)
 				return beta;
 		}
 
+		// ProbCut: if a good capture beats beta by a margin in a reduced search, the full search would most likely fail high as well
+		int probcut_beta = beta + _ProbCut_Margin;
+
+		if (!pvNode
+			&& !excluded_move.isValid()
+			&& depthleft >= _ProbCut_Depth
+			&& !board.isInCheck(toMove)
+			&& std::abs(beta) < SCORE_MIN_MATE)
+		{
+			MoveSelect::MoveSelector<toMove, true> probcut_mg(board);
+			for (; !probcut_mg.end(); probcut_mg.next())
+			{
+				Move move = probcut_mg.curr();
+				if (move.isCapture() && !move.isPromotion() && eval + see<toMove>(board, move) < probcut_beta)
+					continue;
+
+				Board board_copy = board;
+				if (!board_copy.makeMove(move))
+					continue;
+
+				ss.current_move = move;
+				ss.reduction = 0;
+
+				int score = -_quiescence<~toMove>(board_copy, -probcut_beta, -probcut_beta + 1);
+				if (score >= probcut_beta)
+				{
+					_repetitions.push(board_copy.hash(), RepetitionTable::isIrreversible(move));
+					score = -_alphaBeta<~toMove, false, true>(board_copy, -probcut_beta, -probcut_beta + 1, depthleft - _ProbCut_Reduction, ply + 1);
+					_repetitions.pop();
+				}
+
+				if (score == -SCORE_INVALID)
+					return SCORE_INVALID;
+
+				if (score >= probcut_beta)
+				{
+					++stats.probcut_prunes;
+					_transposition_table.insert(board.hash(), depthleft - _ProbCut_Reduction + 1, _scoreToTT(beta, ply), move, LOWER_BOUND);
+					return beta;
+				}
+			}
+		}
+
 		// Razoring
 		int margin = _razorMargin(depthleft);
 
 		if (!board.isInCheck(toMove)
+			&& !excluded_move.isValid()
 			&& depthleft <= 3
 			&& !pvNode
 			&& eval + margin <= alpha)
 		{
 			int res = _quiescence<toMove>(board, alpha - margin, beta - margin);
+			if (res == SCORE_INVALID)
+				return SCORE_INVALID;
+
 			if (res + margin <= alpha)
 				depthleft--;
 
@@ -285,13 +650,16 @@ namespace Search
 				return alpha;
 		}
 
-		//// Internal iterative deepening
-		//if (depthleft >= Params.IID_Depth && !hash_move.isValid() && pvNode)
-		//{
-		//	Board board_copy = board;
-		//	alphaBeta<toMove, true, false>(board_copy, alpha, beta, depthleft - Params.IID_Reduction, ply + 1, nullptr);
-		//	hash_move = searchInfo.transposition_table.probe(board.hash(), 0, alpha, beta).second;
-		//}
+		// Internal iterative reduction: a PV node without a hash move is searched shallower, the
+		// next iteration finds the best move of this search in the transposition table
+		if (pvNode
+			&& depthleft >= _IID_Depth
+			&& !hash_move.isValid()
+			&& !excluded_move.isValid())
+		{
+			depthleft -= _IID_Reduction;
+			++stats.iid_reductions;
+		}
 
 		// Depth extension
 		if (board.isInCheck(toMove))
@@ -299,52 +667,178 @@ namespace Search
 			depthleft++;
 		}
 
-		int curr_pos = 0;
-		int searched_moves = 0;
-		int alpha_orig = alpha;
+		// Singular extension: if every other move fails low against a margin below the stored score
+		// of the hash move, the hash move is extended. If the margin is still above beta, some other
+		// move also beats beta, so the node is pruned (multi-cut).
 		int score;
-		std::array<Move, MAX_DEPTH> new_pv;
-		std::array<Move, MAX_DEPTH>* new_pv_ptr = nullptr;
-
-		if (pvNode)
+		bool singular = false;
+
+		if (ply
+			&& depthleft >= _Singular_Depth
+			&& has_entry
+			&& hash_move.isValid()
+			&& (entry.nodeType == LOWER_BOUND || entry.nodeType == EXACT)
+			&& entry.depth >= depthleft - 3
+			&& std::abs(entry.score) < SCORE_MIN_MATE)
 		{
-			new_pv_ptr = &new_pv;
+			int singular_beta = entry.score - _Singular_Margin * depthleft;
+
+			ss.excluded_move = hash_move;
+			score = _alphaBeta<toMove, false, false>(board, singular_beta - 1, singular_beta, (depthleft - 1) / 2, ply);
+			ss.excluded_move = Move();
+
+			if (score == SCORE_INVALID)
+				return SCORE_INVALID;
+
+			if (score < singular_beta)
+			{
+				singular = true;
+				++stats.singular_extensions;
+			}
+			else if (singular_beta >= beta)
+			{
+				++stats.multi_cut_prunes;
+				return singular_beta;
+			}
 		}
 
-		MoveSelect::MoveSelector<toMove, false> mg(board, hash_move, _killer_moves[ply]);
+		int curr_pos = 0;
+		int searched_moves = 0;
+		int alpha_orig = alpha;
+		// The best score of the root, where alpha is the score of the last line with MultiPV
+		int best_score = alpha;
+		Move counter_move = Move();
+		if (prev_move.isValid() && !prev_move.isNull())
+			counter_move = _counter_moves[~toMove][prev_move.pieceType()][prev_move.to()];
+
+		Move quiet_moves[MAX_MOVES];
+		int quiet_count = 0;
+
+		MoveSelect::MoveSelector<toMove, false> mg = ply == 0
+			? MoveSelect::MoveSelector<toMove, false>(board, _root_order.data(), (int)_root_order.size())
+			: MoveSelect::MoveSelector<toMove, false>(board, hash_move, ss.killer_moves, counter_move, _move_history.get(), prev_move);
 		stats._move_gen_count++;
 
 		for(int i = 1; !mg.end(); ++i, mg.next())
 		{
+			RootMove *root_move = nullptr;
+			if (mg.curr() == excluded_move || (ply == 0 && !(root_move = _findRootMove(mg.curr()))))
+				continue;
+
+			_transposition_table.prefetch(board.hashAfter(mg.curr()));
+
 			Board board_copy = board;
 
 			if (!board_copy.makeMove(mg.curr()))
 				continue;
 
-			if (_isRepetition(board_copy.hash(), ply))
+			int new_depth = depthleft - 1 + (singular && mg.curr() == hash_move);
+
+			// Pruning of moves near the horizon, once a move has been searched and we are not getting mated
+			if (!pvNode
+				&& searched_moves >= 1
+				&& alpha > -SCORE_MIN_MATE
+				&& !mg.curr().isPromotion()
+				&& !board.isInCheck(toMove)
+				&& !board_copy.isInCheck(~toMove))
 			{
+				if (mg.curr().isQuiet())
+				{
+					// Late move pruning
+					if (depthleft <= _LMP_Depth && searched_moves >= _LMP_MoveCount + depthleft * depthleft)
+					{
+						++stats.late_move_prunes;
+						continue;
+					}
+
+					// Futility pruning
+					if (depthleft <= _Futility_Depth && eval + _Futility_Margin * depthleft <= alpha)
+					{
+						++stats.futility_prunes;
+						continue;
+					}
+				}
+
+				// SEE pruning
+				if (depthleft <= _SEE_Depth
+					&& see<toMove>(board, mg.curr()) < -(mg.curr().isQuiet() ? _SEE_Quiet_Margin : _SEE_Capture_Margin) * depthleft)
+				{
+					++stats.see_prunes;
+					continue;
+				}
+			}
+
+			ss.current_move = mg.curr();
+			ss.reduction = 0;
+
+			u64 nodes_before = ply == 0 ? stats.alpha_beta_nodes + stats.quiescence_nodes : 0;
+
+			bool irreversible = RepetitionTable::isIrreversible(mg.curr());
+			if (_repetitions.isRepetition(board_copy.hash(), irreversible))
+			{
+				if (pvNode)
+					_stack[ply + 1].pv_length = 0;
+
 				score = 0;
 				goto SearchEnd;
 			}
 
-			if (onCurrentMove && ply == 0)
-				onCurrentMove(mg.curr(), searched_moves + 1);
+			if (onCurrentMove && root_move && Timer.elapsed_time >= _currmove_delay)
+				onCurrentMove(mg.curr(), searched_moves + 1, root_move->previous_nodes);
 
-			if (searched_moves < 1)
-				score = -_alphaBeta<~toMove, pvNode, false>(board_copy, -beta, -alpha, depthleft - 1, ply + 1, new_pv_ptr);
+			_repetitions.push(board_copy.hash(), irreversible);
+
+			if (root_move && searched_moves < _pv_count && _pv_count > 1)
+				score = _searchLine<~toMove>(board_copy, *root_move, alpha, beta, new_depth, searched_moves > 0, best_score);
+			else if (searched_moves < 1)
+				score = -_alphaBeta<~toMove, pvNode, false>(board_copy, -beta, -alpha, new_depth, ply + 1);
 			else
 			{
-				score = -_alphaBeta<~toMove, false, true>(board_copy, -(alpha + 1), -alpha, depthleft - 1, ply + 1, nullptr);
-				if (score > alpha)
+				int reduction = 0;
+
+				// Late move reductions
+				if (depthleft >= _LMR_Depth
+					&& searched_moves >= _LMR_MoveCount
+					&& mg.curr().isQuiet()
+					&& mg.curr() != ss.killer_moves.first
+					&& mg.curr() != ss.killer_moves.second
+					&& !board.isInCheck(toMove)
+					&& !board_copy.isInCheck(~toMove))
+				{
+					reduction = _Reductions[std::min(depthleft, MAX_DEPTH - 1)][std::min(searched_moves, MAX_MOVES - 1)];
+					if (pvNode)
+						reduction--;
+					reduction = std::max(0, std::min(reduction, new_depth - 1));
+
+					if (reduction)
+						++stats.lmr_reductions;
+
+					ss.reduction = reduction;
+				}
+
+				score = -_alphaBeta<~toMove, false, true>(board_copy, -(alpha + 1), -alpha, new_depth - reduction, ply + 1);
+				if (reduction && score > alpha)
+				{
+					++stats.lmr_research_count;
+					score = -_alphaBeta<~toMove, false, true>(board_copy, -(alpha + 1), -alpha, new_depth, ply + 1);
+				}
+
+				// A null window search is already the full search of a non-PV node
+				if (pvNode && score > alpha && score < beta)
 				{
 					++stats.pv_search_research_count;
-					score = -_alphaBeta<~toMove, pvNode, false>(board_copy, -beta, -alpha, depthleft - 1, ply + 1, new_pv_ptr);
+					score = -_alphaBeta<~toMove, pvNode, false>(board_copy, -beta, -alpha, new_depth, ply + 1);
 				}
 			}
 
+			_repetitions.pop();
+
 			if (score == -SCORE_INVALID)
 				return SCORE_INVALID;
 
+			if (root_move)
+				root_move->nodes += stats.alpha_beta_nodes + stats.quiescence_nodes - nodes_before;
+
 SearchEnd:
 
 			++searched_moves;
@@ -367,28 +861,64 @@ SearchEnd:
 
 				if (mg.curr().isQuiet())
 				{
-					if (mg.curr() == _killer_moves[ply].first || mg.curr() == _killer_moves[ply].second)
+					if (mg.curr() == ss.killer_moves.first || mg.curr() == ss.killer_moves.second)
 						++stats.killer_move_cutoffs;
 
-					_killer_moves[ply].second = _killer_moves[ply].first;
-					_killer_moves[ply].first = mg.curr();
+					if (mg.curr() != ss.killer_moves.first)
+					{
+						ss.killer_moves.second = ss.killer_moves.first;
+						ss.killer_moves.first = mg.curr();
+					}
+
+					int bonus = std::min(depthleft * depthleft, _History_Max_Bonus);
+					_move_history->update<toMove>(mg.curr(), prev_move, bonus);
+					for (int j = 0; j < quiet_count; ++j)
+						_move_history->update<toMove>(quiet_moves[j], prev_move, -bonus);
+
+					if (prev_move.isValid() && !prev_move.isNull())
+						_counter_moves[~toMove][prev_move.pieceType()][prev_move.to()] = mg.curr();
+				}
+
+				if (pvNode)
+				{
+					_stack[ply + 1].pv_length = 0;
+					_updatePv(ply, mg.curr());
 				}
 
 				assert(mg.curr() != Move());
-				_transposition_table.insert(board.hash(), depthleft, beta, mg.curr(), LOWER_BOUND);
+				if (!excluded_move.isValid())
+					_transposition_table.insert(board.hash(), depthleft, _scoreToTT(beta, ply), mg.curr(), LOWER_BOUND);
 				return beta;
 			}
 
+			if (mg.curr().isQuiet())
+				quiet_moves[quiet_count++] = mg.curr();
+
 			if (score > alpha)
 			{
-				alpha = score;
-
-				if (pv)
+				if (root_move)
 				{
-					assert(new_pv_ptr != nullptr && pv != nullptr);
+					// A root move above alpha has an exact score, the later moves are searched against
+					// the score of the last line
+					root_move->score = score;
+					root_move->pv.fill(Move());
+					root_move->pv[0] = mg.curr();
+					std::copy(_pvRow(1), _pvRow(1) + _stack[1].pv_length, root_move->pv.begin() + 1);
+
+					if (score > best_score)
+					{
+						best_score = score;
+						_updatePv(ply, mg.curr());
+					}
+
+					alpha = _lastLineScore(alpha_orig);
+				}
+				else
+				{
+					alpha = score;
 
-					(*pv)[0] = mg.curr();
-					std::copy(new_pv.begin(), new_pv.begin() + depthleft - 1, pv->begin() + 1);
+					if (pvNode)
+						_updatePv(ply, mg.curr());
 				}
 
 				if (alpha == SCORE_MAX_MATE - 1)
@@ -398,20 +928,29 @@ SearchEnd:
 
 		if (searched_moves == 0)
 		{
-			if (board.isInCheck(toMove))
+			if (excluded_move.isValid())
+				return alpha;
+			else if (board.isInCheck(toMove))
 				return -SCORE_MAX_MATE;
 			else
 				return SCORE_DRAW;
 		}
 
+		if (excluded_move.isValid())
+			return alpha;
+
+		// With MultiPV the root returns the best line, alpha only bounds the last one
+		if (ply == 0 && _pv_count > 1)
+			return best_score;
+
 		if (alpha == alpha_orig)
 		{
-			_transposition_table.insert(board.hash(), depthleft, alpha, Move(), UPPER_BOUND);
+			_transposition_table.insert(board.hash(), depthleft, _scoreToTT(alpha, ply), Move(), UPPER_BOUND);
 		}
-		else if (pv)
+		else if (pvNode)
 		{
-			assert((*pv)[0] != Move());
-			_transposition_table.insert(board.hash(), depthleft, alpha, (*pv)[0], EXACT);
+			assert(ss.pv_length > 0);
+			_transposition_table.insert(board.hash(), depthleft, _scoreToTT(alpha, ply), _pvRow(ply)[0], EXACT);
 		}
 
 		return alpha;
@@ -9,10 +9,11 @@
 Bitboard _getAttackers(const Board & board, Color to_move, Bitboard occupied, Square square);
 Square _getLeastValuableAttacker(const Board & board, Color to_move, Bitboard attackers);
 
+// Static exchange evaluation of the move, quiet moves are treated as capturing nothing
 template <Color toMove>
 int see(const Board & board, Move move)
 {
-	if (board.pieceAt(move.to()) == NO_PIECE)
+	if (move.isEnPassant())
 		return 0;
 
 	Square attacker[2];
@@ -25,7 +26,7 @@ int see(const Board & board, Move move)
 
 	PieceType curr_piece = move.pieceType();
 
-	scores[0] = Evaluation::PieceValue[toPieceType(board.pieceAt(move.to()))].mg;
+	scores[0] = board.pieceAt(move.to()) == NO_PIECE ? 0 : Evaluation::PieceValue[toPieceType(board.pieceAt(move.to()))].mg;
 
 	Bitboard attackers_bb[2];
 	Color color = toMove;
@@ -0,0 +1,1202 @@
+// The probing code is adapted from tbprobe.cpp of Stockfish, Copyright (C) 2016 Marco Costalba and Lucas
+// Braesch, which is based on the Syzygy probing code of Ronald de Man, Copyright (c) 2013. Stockfish is
+// distributed under the GNU General Public License, version 3 or later, and this file is under the same terms.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include "attacks.h"
+#include "mapped_file.h"
+#include "movegen.h"
+#include "tablebase.h"
+#include "util.h"
+
+namespace Tablebase
+{
+	namespace
+	{
+		enum TableType
+		{
+			WDL, DTZ
+		};
+
+		enum ProbeState
+		{
+			FAIL, OK, CHANGE_STM, ZEROING_BEST_MOVE
+		};
+
+		enum PairsFlag
+		{
+			FLAG_STM = 1, FLAG_MAPPED = 2, FLAG_WIN_PLIES = 4, FLAG_LOSS_PLIES = 8, FLAG_WIDE = 16, FLAG_SINGLE_VALUE = 128
+		};
+
+		const unsigned char Magic[2][4] = { { 0x71, 0xE8, 0x23, 0x5D }, { 0xD7, 0x66, 0x0C, 0xA5 } };
+
+		const std::string PieceChars = "PNBRQK";
+
+		// The compressed values of one side to move and one file of the leading pawn
+		struct PairsData
+		{
+			int flags;
+			size_t block_size;
+			size_t span;
+			size_t block_count;
+			size_t block_length_size;
+			size_t sparse_index_size;
+			int min_sym_len;
+			const unsigned char *lowest_sym;
+			const unsigned char *btree;
+			const unsigned char *sparse_index;
+			const unsigned char *block_length;
+			const unsigned char *data;
+			std::vector<u64> base64;
+			std::vector<unsigned char> symlen;
+
+			// The pieces in the order of the encoding, and the groups of pieces encoded together
+			int pieces[MaxPieces];
+			u64 group_idx[MaxPieces + 1];
+			int group_len[MaxPieces + 1];
+
+			// Where the value maps of the DTZ table start for each result
+			int map_idx[4];
+		};
+
+		struct Table
+		{
+			TableType type;
+			std::string name;
+
+			// The material of the name with the first side as white, and as black
+			u64 key;
+			u64 key2;
+
+			int piece_count;
+			bool has_pawns;
+			bool has_unique_pieces;
+
+			// The pawns of the leading color, the one with fewer pawns, and of the other color
+			int pawn_count[COLOR_NB];
+
+			std::atomic<bool> ready;
+			bool valid;
+			MappedFile file;
+			PairsData items[COLOR_NB][4];
+			const unsigned char *map;
+
+			PairsData *get(int stm, int file)
+			{
+				return &items[type == WDL ? stm : 0][has_pawns ? file : 0];
+			}
+		};
+
+		std::vector<std::string> Paths;
+		std::deque<Table> Tables;
+
+		// The WDL and the DTZ table of each material
+		std::unordered_map<u64, std::pair<Table*, Table*>> TableMap;
+		int MaxCardinality = 0;
+
+		std::mutex MapMutex;
+
+		int MapB1H1H7[SQUARE_NB];
+		int MapA1D1D4[SQUARE_NB];
+		int MapKK[10][SQUARE_NB];
+		u64 Binomial[6][SQUARE_NB];
+		int MapPawns[SQUARE_NB];
+		u64 LeadPawnIdx[6][SQUARE_NB];
+		u64 LeadPawnsSize[6][4];
+
+		unsigned readLe16(const unsigned char *p)
+		{
+			return p[0] | p[1] << 8;
+		}
+
+		unsigned readLe32(const unsigned char *p)
+		{
+			return p[0] | p[1] << 8 | p[2] << 16 | (unsigned)p[3] << 24;
+		}
+
+		unsigned readBe32(const unsigned char *p)
+		{
+			return (unsigned)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+		}
+
+		u64 readBe64(const unsigned char *p)
+		{
+			return (u64)readBe32(p) << 32 | readBe32(p + 4);
+		}
+
+		// The children of a symbol in the tree of the recursive pairing, packed in 3 bytes
+		int btreeLeft(const PairsData *d, int sym)
+		{
+			const unsigned char *lr = d->btree + 3 * sym;
+			return ((lr[1] & 0xF) << 8) | lr[0];
+		}
+
+		int btreeRight(const PairsData *d, int sym)
+		{
+			const unsigned char *lr = d->btree + 3 * sym;
+			return (lr[2] << 4) | (lr[1] >> 4);
+		}
+
+		// Pieces are coded as in the files: 1 (pawn) to 6 (king), plus 8 for black
+		int tbPiece(Piece piece)
+		{
+			return (toPieceType(piece) + 1) | (pieceColor(piece) << 3);
+		}
+
+		int offA1H8(Square square)
+		{
+			return Util::getRank(square) - Util::getFile(square);
+		}
+
+		Square flipFile(Square square)
+		{
+			return Square(square ^ 7);
+		}
+
+		Square flipRank(Square square)
+		{
+			return Square(square ^ 56);
+		}
+
+		bool pawnsCompare(Square a, Square b)
+		{
+			return MapPawns[a] < MapPawns[b];
+		}
+
+		u64 materialKey(const int count[COLOR_NB][PIECE_TYPE_NB], Color white)
+		{
+			u64 key = 0;
+			for (Color color : Colors)
+			{
+				for (PieceType piece_type = PAWN; piece_type < PIECE_TYPE_NB; ++piece_type)
+					key |= (u64)count[color == WHITE ? white : ~white][piece_type] << (4 * (color * PIECE_TYPE_NB + piece_type));
+			}
+			return key;
+		}
+
+		u64 materialKey(const Board &board)
+		{
+			int count[COLOR_NB][PIECE_TYPE_NB];
+			for (Color color : Colors)
+			{
+				for (PieceType piece_type = PAWN; piece_type < PIECE_TYPE_NB; ++piece_type)
+					count[color][piece_type] = board.numOfPieces(color, piece_type);
+			}
+			return materialKey(count, WHITE);
+		}
+
+		void initEncoding()
+		{
+			int code = 0;
+			for (Square square : Squares)
+			{
+				if (offA1H8(square) < 0)
+					MapB1H1H7[square] = code++;
+			}
+
+			// The a1-d1-d4 triangle, the squares of the diagonal last
+			std::vector<Square> diagonal;
+			code = 0;
+			for (Square square = A1; square <= D4; ++square)
+			{
+				if (offA1H8(square) < 0 && Util::getFile(square) <= D_FILE)
+					MapA1D1D4[square] = code++;
+				else if (!offA1H8(square) && Util::getFile(square) <= D_FILE)
+					diagonal.push_back(square);
+			}
+			for (Square square : diagonal)
+				MapA1D1D4[square] = code++;
+
+			// The 462 placements of two kings with the first in the a1-d1-d4 triangle. If the first
+			// is on the diagonal, the second is not above it. Both on the diagonal come last.
+			std::vector<std::pair<int, Square>> both_on_diagonal;
+			code = 0;
+			for (int idx = 0; idx < 10; idx++)
+			{
+				for (Square s1 = A1; s1 <= D4; ++s1)
+				{
+					if (MapA1D1D4[s1] != idx || (!idx && s1 != B1))
+						continue;
+
+					for (Square s2 : Squares)
+					{
+						if ((Attacks::kingAttacks(s1) | Constants::SquareBB[s1]) & Constants::SquareBB[s2])
+							continue;
+						else if (!offA1H8(s1) && offA1H8(s2) > 0)
+							continue;
+						else if (!offA1H8(s1) && !offA1H8(s2))
+							both_on_diagonal.push_back(std::make_pair(idx, s2));
+						else
+							MapKK[idx][s2] = code++;
+					}
+				}
+			}
+			for (auto &kings : both_on_diagonal)
+				MapKK[kings.first][kings.second] = code++;
+
+			std::memset(Binomial, 0, sizeof(Binomial));
+			Binomial[0][0] = 1;
+			for (int n = 1; n < SQUARE_NB; n++)
+			{
+				for (int k = 0; k < 6 && k <= n; ++k)
+					Binomial[k][n] = (k > 0 ? Binomial[k - 1][n - 1] : 0) + (k < n ? Binomial[k][n - 1] : 0);
+			}
+
+			// The pawn squares from the edge files inwards and from the second rank up. The leading
+			// pawn is the one with the highest value, the others can't have higher ones.
+			int available_squares = 47;
+			for (int lead_pawns = 1; lead_pawns <= 5; ++lead_pawns)
+			{
+				for (File file = A_FILE; file <= D_FILE; ++file)
+				{
+					u64 idx = 0;
+					for (Rank rank = RANK_2; rank <= RANK_7; ++rank)
+					{
+						Square square = Square(rank * 8 + file);
+						if (lead_pawns == 1)
+						{
+							MapPawns[square] = available_squares--;
+							MapPawns[flipFile(square)] = available_squares--;
+						}
+						LeadPawnIdx[lead_pawns][square] = idx;
+						idx += Binomial[lead_pawns - 1][MapPawns[square]];
+					}
+					LeadPawnsSize[lead_pawns][file] = idx;
+				}
+			}
+		}
+
+		void setGroups(Table &table, PairsData *d, const int order[2], int file)
+		{
+			int n = 0, first_len = table.has_pawns ? 0 : table.has_unique_pieces ? 3 : 2;
+			d->group_len[n] = 1;
+
+			for (int i = 1; i < table.piece_count; ++i)
+			{
+				if (--first_len > 0 || d->pieces[i] == d->pieces[i - 1])
+					d->group_len[n]++;
+				else
+					d->group_len[++n] = 1;
+			}
+			d->group_len[++n] = 0;
+
+			// The groups are encoded in the order given by the table, the leading group at order[0]
+			// and the remaining pawns at order[1]
+			bool pp = table.has_pawns && table.pawn_count[1];
+			int next = pp ? 2 : 1;
+			int free_squares = 64 - d->group_len[0] - (pp ? d->group_len[1] : 0);
+			u64 idx = 1;
+
+			for (int k = 0; next < n || k == order[0] || k == order[1]; ++k)
+			{
+				if (k == order[0])
+				{
+					d->group_idx[0] = idx;
+					idx *= table.has_pawns ? LeadPawnsSize[d->group_len[0]][file] : table.has_unique_pieces ? 31332 : 462;
+				}
+				else if (k == order[1])
+				{
+					d->group_idx[1] = idx;
+					idx *= Binomial[d->group_len[1]][48 - d->group_len[0]];
+				}
+				else
+				{
+					d->group_idx[next] = idx;
+					idx *= Binomial[d->group_len[next]][free_squares];
+					free_squares -= d->group_len[next++];
+				}
+			}
+			d->group_idx[n] = idx;
+		}
+
+		int setSymlen(PairsData *d, int sym, std::vector<bool> &visited)
+		{
+			visited[sym] = true;
+
+			int right = btreeRight(d, sym);
+			if (right == 0xFFF)
+				return 0;
+
+			int left = btreeLeft(d, sym);
+			if (!visited[left])
+				d->symlen[left] = setSymlen(d, left, visited);
+			if (!visited[right])
+				d->symlen[right] = setSymlen(d, right, visited);
+
+			return d->symlen[left] + d->symlen[right] + 1;
+		}
+
+		const unsigned char *setSizes(PairsData *d, const unsigned char *data)
+		{
+			d->flags = *data++;
+
+			if (d->flags & FLAG_SINGLE_VALUE)
+			{
+				d->block_size = d->block_count = d->block_length_size = 0;
+				d->span = d->sparse_index_size = 0;
+				d->min_sym_len = *data++;
+				return data;
+			}
+
+			// The index after the last group is the size of the table
+			u64 table_size = d->group_idx[std::find(d->group_len, d->group_len + MaxPieces, 0) - d->group_len];
+
+			d->block_size = (size_t)1 << *data++;
+			d->span = (size_t)1 << *data++;
+			d->sparse_index_size = (size_t)((table_size + d->span - 1) / d->span);
+			int padding = *data++;
+			d->block_count = readLe32(data);
+			data += 4;
+
+			// The block lengths are padded so the sparse index can't point past them
+			d->block_length_size = d->block_count + padding;
+
+			int max_sym_len = *data++;
+			d->min_sym_len = *data++;
+			d->lowest_sym = data;
+			d->base64.assign(max_sym_len - d->min_sym_len + 1, 0);
+
+			// Canonical Huffman code: longer codes have lower values. base64[i] is the lowest code
+			// of length min_sym_len + i, left aligned in 64 bits.
+			for (int i = (int)d->base64.size() - 2; i >= 0; --i)
+				d->base64[i] = (d->base64[i + 1] + readLe16(d->lowest_sym + 2 * i) - readLe16(d->lowest_sym + 2 * (i + 1))) / 2;
+
+			for (size_t i = 0; i < d->base64.size(); ++i)
+				d->base64[i] <<= 64 - i - d->min_sym_len;
+
+			data += d->base64.size() * 2;
+			d->symlen.assign(readLe16(data), 0);
+			data += 2;
+			d->btree = data;
+
+			// The symbols stand for pairs of symbols, recursively. symlen is the number of values of
+			// a symbol minus one.
+			std::vector<bool> visited(d->symlen.size());
+			for (int sym = 0; sym < (int)d->symlen.size(); ++sym)
+			{
+				if (!visited[sym])
+					d->symlen[sym] = setSymlen(d, sym, visited);
+			}
+
+			return data + d->symlen.size() * 3 + (d->symlen.size() & 1);
+		}
+
+		const unsigned char *setDtzMap(Table &table, const unsigned char *base, const unsigned char *data, int max_file)
+		{
+			table.map = data;
+
+			for (int file = 0; file <= max_file; ++file)
+			{
+				PairsData *d = table.get(0, file);
+				if (!(d->flags & FLAG_MAPPED))
+					continue;
+
+				if (d->flags & FLAG_WIDE)
+				{
+					data += (data - base) & 1;
+					for (int i = 0; i < 4; ++i)
+					{
+						d->map_idx[i] = (int)((data - table.map) / 2 + 1);
+						data += 2 * readLe16(data) + 2;
+					}
+				}
+				else
+				{
+					for (int i = 0; i < 4; ++i)
+					{
+						d->map_idx[i] = (int)(data - table.map + 1);
+						data += *data + 1;
+					}
+				}
+			}
+
+			return data + ((data - base) & 1);
+		}
+
+		bool parseTable(Table &table, const unsigned char *base)
+		{
+			const unsigned char *data = base + 4;
+
+			if (table.has_pawns != bool(*data & 2) || (table.key != table.key2) != bool(*data & 1))
+				return false;
+			data++;
+
+			int sides = table.type == WDL && table.key != table.key2 ? 2 : 1;
+			int max_file = table.has_pawns ? 3 : 0;
+
+			// Pawns on both sides
+			bool pp = table.has_pawns && table.pawn_count[1];
+
+			for (int file = 0; file <= max_file; ++file)
+			{
+				int order[2][2] = {
+					{ *data & 0xF, pp ? *(data + 1) & 0xF : 0xF },
+					{ *data >> 4, pp ? *(data + 1) >> 4 : 0xF }
+				};
+				data += 1 + pp;
+
+				for (int k = 0; k < table.piece_count; ++k, ++data)
+				{
+					for (int i = 0; i < sides; i++)
+						table.get(i, file)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+				}
+
+				for (int i = 0; i < sides; ++i)
+					setGroups(table, table.get(i, file), order[i], file);
+			}
+
+			data += (data - base) & 1;
+
+			for (int file = 0; file <= max_file; ++file)
+			{
+				for (int i = 0; i < sides; i++)
+					data = setSizes(table.get(i, file), data);
+			}
+
+			if (table.type == DTZ)
+				data = setDtzMap(table, base, data, max_file);
+
+			for (int file = 0; file <= max_file; ++file)
+			{
+				for (int i = 0; i < sides; i++)
+				{
+					PairsData *d = table.get(i, file);
+					d->sparse_index = data;
+					data += d->sparse_index_size * 6;
+				}
+			}
+
+			for (int file = 0; file <= max_file; ++file)
+			{
+				for (int i = 0; i < sides; i++)
+				{
+					PairsData *d = table.get(i, file);
+					d->block_length = data;
+					data += d->block_length_size * 2;
+				}
+			}
+
+			for (int file = 0; file <= max_file; ++file)
+			{
+				for (int i = 0; i < sides; i++)
+				{
+					// The blocks start at 64 byte boundaries
+					data = base + (((data - base) + 0x3F) & ~0x3F);
+
+					PairsData *d = table.get(i, file);
+					d->data = data;
+					data += d->block_count * d->block_size;
+				}
+			}
+
+			return data <= base + table.file.size();
+		}
+
+		bool mapTable(Table &table)
+		{
+			if (table.ready.load(std::memory_order_acquire))
+				return table.valid;
+
+			std::lock_guard<std::mutex> lock(MapMutex);
+			if (table.ready.load(std::memory_order_relaxed))
+				return table.valid;
+
+			const std::string extension = table.type == WDL ? ".rtbw" : ".rtbz";
+			for (const std::string &path : Paths)
+			{
+				if (table.file.open(path + "/" + table.name + extension))
+					break;
+			}
+
+			table.valid = table.file.isOpen()
+				&& table.file.size() % 64 == 16
+				&& std::memcmp(table.file.data(), Magic[table.type], 4) == 0
+				&& parseTable(table, table.file.data());
+
+			if (!table.valid)
+				table.file.close();
+
+			table.ready.store(true, std::memory_order_release);
+			return table.valid;
+		}
+
+		int decompressPairs(PairsData *d, u64 idx)
+		{
+			if (d->flags & FLAG_SINGLE_VALUE)
+				return d->min_sym_len;
+
+			// The sparse index stores the block and the offset in it of the value in the middle of
+			// every span, the block of idx is found by walking the block lengths from there
+			size_t k = (size_t)(idx / d->span);
+			const unsigned char *entry = d->sparse_index + 6 * k;
+			size_t block = readLe32(entry);
+			long long offset = readLe16(entry + 4);
+
+			offset += (long long)(idx % d->span) - (long long)(d->span / 2);
+
+			while (offset < 0)
+				offset += readLe16(d->block_length + 2 * --block) + 1;
+
+			while (offset > readLe16(d->block_length + 2 * block))
+				offset -= readLe16(d->block_length + 2 * block++) + 1;
+
+			const unsigned char *ptr = d->data + block * d->block_size;
+
+			u64 buf64 = readBe64(ptr);
+			ptr += 8;
+			int buf64_size = 64;
+			int sym;
+
+			while (true)
+			{
+				int len = 0;
+				while (buf64 < d->base64[len])
+					++len;
+
+				sym = (int)((buf64 - d->base64[len]) >> (64 - len - d->min_sym_len));
+				sym += readLe16(d->lowest_sym + 2 * len);
+
+				if (offset < d->symlen[sym] + 1)
+					break;
+
+				offset -= d->symlen[sym] + 1;
+				len += d->min_sym_len;
+				buf64 <<= len;
+				buf64_size -= len;
+
+				if (buf64_size <= 32)
+				{
+					buf64_size += 32;
+					buf64 |= (u64)readBe32(ptr) << (64 - buf64_size);
+					ptr += 4;
+				}
+			}
+
+			// Expand the symbol to the value at the offset
+			while (d->symlen[sym])
+			{
+				int left = btreeLeft(d, sym);
+				if (offset < d->symlen[left] + 1)
+					sym = left;
+				else
+				{
+					offset -= d->symlen[left] + 1;
+					sym = btreeRight(d, sym);
+				}
+			}
+
+			return btreeLeft(d, sym);
+		}
+
+		int mapScore(Table &table, int file, int value, Wdl wdl)
+		{
+			if (table.type == WDL)
+				return value - 2;
+
+			const int WdlMap[] = { 1, 3, 0, 2, 0 };
+			PairsData *d = table.get(0, file);
+
+			if (d->flags & FLAG_MAPPED)
+			{
+				if (d->flags & FLAG_WIDE)
+					value = readLe16(table.map + 2 * (d->map_idx[WdlMap[wdl + 2]] + value));
+				else
+					value = table.map[d->map_idx[WdlMap[wdl + 2]] + value];
+			}
+
+			// The distances are stored in moves unless the table needs plies
+			if ((wdl == WDL_WIN && !(d->flags & FLAG_WIN_PLIES))
+				|| (wdl == WDL_LOSS && !(d->flags & FLAG_LOSS_PLIES))
+				|| wdl == WDL_CURSED_WIN
+				|| wdl == WDL_BLESSED_LOSS)
+			{
+				value *= 2;
+			}
+
+			return value + 1;
+		}
+
+		int probeTable(Table &table, const Board &board, Wdl wdl, ProbeState &result)
+		{
+			Square squares[MaxPieces];
+			int pieces[MaxPieces];
+			int size = 0, lead_pawns_count = 0;
+			Bitboard lead_pawns = 0;
+			int file = 0;
+			u64 idx;
+
+			// Symmetric tables only store white to move, and the tables have the first side of the
+			// name as white, so the colors and the ranks are flipped if needed
+			bool symmetric_black_to_move = table.key == table.key2 && board.toMove() == BLACK;
+			bool black_stronger = materialKey(board) != table.key;
+			bool flip = symmetric_black_to_move || black_stronger;
+
+			int flip_color = flip ? 8 : 0;
+			int flip_squares = flip ? 56 : 0;
+			int stm = flip ^ (board.toMove() == BLACK);
+
+			// The tables of pawn endings are split by the file of the leading pawn: the one nearest
+			// to the edge, and the lowest of those
+			if (table.has_pawns)
+			{
+				int lead_piece = table.get(0, 0)->pieces[0] ^ flip_color;
+				lead_pawns = board.pieces(Color(lead_piece >> 3), PAWN);
+
+				for (Square square : BitboardIterator<Square>(lead_pawns))
+					squares[size++] = Square(square ^ flip_squares);
+
+				lead_pawns_count = size;
+				std::swap(squares[0], *std::max_element(squares, squares + lead_pawns_count, pawnsCompare));
+
+				file = std::min((int)Util::getFile(squares[0]), 7 - Util::getFile(squares[0]));
+			}
+
+			// The DTZ tables store one side to move, the other side has to be probed by a search
+			if (table.type == DTZ)
+			{
+				int flags = table.get(stm, file)->flags;
+				if ((flags & FLAG_STM) != stm && (table.key != table.key2 || table.has_pawns))
+				{
+					result = CHANGE_STM;
+					return 0;
+				}
+			}
+
+			for (Square square : BitboardIterator<Square>(board.occupied() ^ lead_pawns))
+			{
+				squares[size] = Square(square ^ flip_squares);
+				pieces[size++] = tbPiece(board.pieceAt(square)) ^ flip_color;
+			}
+
+			PairsData *d = table.get(stm, file);
+
+			// Order the pieces as the table does
+			for (int i = lead_pawns_count; i < size - 1; ++i)
+			{
+				for (int j = i + 1; j < size; ++j)
+				{
+					if (d->pieces[i] == pieces[j])
+					{
+						std::swap(pieces[i], pieces[j]);
+						std::swap(squares[i], squares[j]);
+						break;
+					}
+				}
+			}
+
+			// The leading piece is mirrored to the files a to d
+			if (Util::getFile(squares[0]) > D_FILE)
+			{
+				for (int i = 0; i < size; ++i)
+					squares[i] = flipFile(squares[i]);
+			}
+
+			if (table.has_pawns)
+			{
+				idx = LeadPawnIdx[lead_pawns_count][squares[0]];
+
+				std::stable_sort(squares + 1, squares + lead_pawns_count, pawnsCompare);
+				for (int i = 1; i < lead_pawns_count; ++i)
+					idx += Binomial[i][MapPawns[squares[i]]];
+			}
+			else
+			{
+				// Without pawns the leading piece is also mirrored to the ranks 1 to 4, and below
+				// the a1-h8 diagonal
+				if (Util::getRank(squares[0]) > RANK_4)
+				{
+					for (int i = 0; i < size; ++i)
+						squares[i] = flipRank(squares[i]);
+				}
+
+				for (int i = 0; i < d->group_len[0]; ++i)
+				{
+					if (!offA1H8(squares[i]))
+						continue;
+
+					if (offA1H8(squares[i]) > 0)
+					{
+						for (int j = i; j < size; ++j)
+							squares[j] = Square(((squares[j] >> 3) | (squares[j] << 3)) & 63);
+					}
+					break;
+				}
+
+				// Three unique pieces, kings included, are encoded together, otherwise only the kings
+				if (table.has_unique_pieces)
+				{
+					int adjust1 = squares[1] > squares[0];
+					int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+					if (offA1H8(squares[0]))
+						idx = (MapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+					else if (offA1H8(squares[1]))
+						idx = (6 * 63 + Util::getRank(squares[0]) * 28 + MapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+					else if (offA1H8(squares[2]))
+						idx = 6 * 63 * 62 + 4 * 28 * 62 + Util::getRank(squares[0]) * 7 * 28
+							+ (Util::getRank(squares[1]) - adjust1) * 28 + MapB1H1H7[squares[2]];
+					else
+						idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + Util::getRank(squares[0]) * 7 * 6
+							+ (Util::getRank(squares[1]) - adjust1) * 6 + (Util::getRank(squares[2]) - adjust2);
+				}
+				else
+					idx = MapKK[MapA1D1D4[squares[0]]][squares[1]];
+			}
+
+			// The remaining groups, each as a combination of the squares left by the previous ones
+			idx *= d->group_idx[0];
+			Square *group_squares = squares + d->group_len[0];
+			bool remaining_pawns = table.has_pawns && table.pawn_count[1];
+
+			for (int next = 1; d->group_len[next]; ++next)
+			{
+				std::stable_sort(group_squares, group_squares + d->group_len[next]);
+				u64 n = 0;
+
+				for (int i = 0; i < d->group_len[next]; ++i)
+				{
+					int adjust = (int)std::count_if(squares, group_squares, [&](Square square) { return group_squares[i] > square; });
+					n += Binomial[i + 1][group_squares[i] - adjust - 8 * remaining_pawns];
+				}
+
+				remaining_pawns = false;
+				idx += n * d->group_idx[next];
+				group_squares += d->group_len[next];
+			}
+
+			return mapScore(table, file, decompressPairs(d, idx), wdl);
+		}
+
+		int probeTable(TableType type, const Board &board, Wdl wdl, ProbeState &result)
+		{
+			if (Util::popCount(board.occupied()) == 2)
+				return type == WDL ? WDL_DRAW : 0;
+
+			auto it = TableMap.find(materialKey(board));
+			Table *table = it == TableMap.end() ? nullptr : type == WDL ? it->second.first : it->second.second;
+
+			if (!table || !mapTable(*table))
+			{
+				result = FAIL;
+				return 0;
+			}
+
+			return probeTable(*table, board, wdl, result);
+		}
+
+		int genMoves(const Board &board, Move *moves)
+		{
+			int size;
+			if (board.toMove() == WHITE)
+				MoveGen::genMoves<WHITE, false>(board, moves, size);
+			else
+				MoveGen::genMoves<BLACK, false>(board, moves, size);
+			return size;
+		}
+
+		bool hasLegalMove(const Board &board)
+		{
+			Move moves[MAX_MOVES];
+			int size = genMoves(board, moves);
+
+			for (int i = 0; i < size; ++i)
+			{
+				Board board_copy = board;
+				if (board_copy.makeMove(moves[i]))
+					return true;
+			}
+			return false;
+		}
+
+		// The tables don't know about en passant captures and are wrong when the only moves are
+		// captures, so the captures (and the pawn moves for DTZ) are searched before the probe
+		Wdl search(const Board &board, bool check_zeroing_moves, ProbeState &result)
+		{
+			Wdl best = WDL_LOSS;
+			Move moves[MAX_MOVES];
+			int size = genMoves(board, moves);
+			int legal_count = 0, searched_count = 0;
+
+			for (int i = 0; i < size; ++i)
+			{
+				Board board_copy = board;
+				if (!board_copy.makeMove(moves[i]))
+					continue;
+
+				++legal_count;
+
+				if (!moves[i].isCapture() && (!check_zeroing_moves || moves[i].pieceType() != PAWN))
+					continue;
+
+				++searched_count;
+
+				Wdl value = Wdl(-search(board_copy, false, result));
+				if (result == FAIL)
+					return WDL_DRAW;
+
+				if (value > best)
+				{
+					best = value;
+					if (value >= WDL_WIN)
+					{
+						result = ZEROING_BEST_MOVE;
+						return value;
+					}
+				}
+			}
+
+			bool no_more_moves = searched_count && searched_count == legal_count;
+
+			Wdl value;
+			if (no_more_moves)
+				value = best;
+			else
+			{
+				value = Wdl(probeTable(WDL, board, WDL_DRAW, result));
+				if (result == FAIL)
+					return WDL_DRAW;
+			}
+
+			if (best >= value)
+			{
+				result = best > WDL_DRAW || no_more_moves ? ZEROING_BEST_MOVE : OK;
+				return best;
+			}
+
+			result = OK;
+			return value;
+		}
+
+		// The DTZ of a position whose best move zeroes the halfmove clock
+		int dtzBeforeZeroing(Wdl wdl)
+		{
+			return wdl == WDL_WIN ? 1
+				: wdl == WDL_CURSED_WIN ? 101
+				: wdl == WDL_BLESSED_LOSS ? -101
+				: wdl == WDL_LOSS ? -1 : 0;
+		}
+
+		int sign(int value)
+		{
+			return (value > 0) - (value < 0);
+		}
+
+		int probeDtz(const Board &board, ProbeState &result)
+		{
+			result = OK;
+			Wdl wdl = search(board, true, result);
+
+			if (result == FAIL || wdl == WDL_DRAW)
+				return 0;
+
+			if (result == ZEROING_BEST_MOVE)
+				return dtzBeforeZeroing(wdl);
+
+			int dtz = probeTable(DTZ, board, wdl, result);
+			if (result == FAIL)
+				return 0;
+
+			if (result != CHANGE_STM)
+				return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * sign(wdl);
+
+			// The table is of the other side to move, so the best move is found by probing the
+			// positions after the moves
+			int min_dtz = 0xFFFF;
+			Move moves[MAX_MOVES];
+			int size = genMoves(board, moves);
+
+			for (int i = 0; i < size; ++i)
+			{
+				Board board_copy = board;
+				if (!board_copy.makeMove(moves[i]))
+					continue;
+
+				bool zeroing = moves[i].isCapture() || moves[i].pieceType() == PAWN;
+
+				// The DTZ of a zeroing move is the one before it, with the sign of the result after it
+				dtz = zeroing ? -dtzBeforeZeroing(search(board_copy, false, result)) : -probeDtz(board_copy, result);
+
+				if (dtz == 1 && board_copy.isInCheck(board_copy.toMove()) && !hasLegalMove(board_copy))
+					min_dtz = 1;
+
+				if (!zeroing)
+					dtz += sign(dtz);
+
+				if (dtz < min_dtz && sign(dtz) == sign(wdl))
+					min_dtz = dtz;
+
+				if (result == FAIL)
+					return 0;
+			}
+
+			// Without legal moves the position is mate
+			return min_dtz == 0xFFFF ? -1 : min_dtz;
+		}
+
+		bool canProbe(const Board &board)
+		{
+			return Util::popCount(board.occupied()) <= MaxCardinality
+				&& !board.canCastle(WHITE, KINGSIDE) && !board.canCastle(WHITE, QUEENSIDE)
+				&& !board.canCastle(BLACK, KINGSIDE) && !board.canCastle(BLACK, QUEENSIDE);
+		}
+
+		void addTable(const std::vector<PieceType> &piece_types)
+		{
+			std::string name;
+			int count[COLOR_NB][PIECE_TYPE_NB] = {};
+			Color color = BLACK;
+
+			for (PieceType piece_type : piece_types)
+			{
+				if (piece_type == KING)
+				{
+					color = ~color;
+					if (color == BLACK)
+						name += 'v';
+				}
+				name += PieceChars[piece_type];
+				count[color][piece_type]++;
+			}
+
+			// Only the WDL file is looked for
+			bool found = false;
+			for (const std::string &path : Paths)
+			{
+				if (std::ifstream(path + "/" + name + ".rtbw"))
+				{
+					found = true;
+					break;
+				}
+			}
+			if (!found)
+				return;
+
+			MaxCardinality = std::max((int)piece_types.size(), MaxCardinality);
+
+			Table *tables[2];
+			for (TableType type : { WDL, DTZ })
+			{
+				Tables.emplace_back();
+				Table &table = Tables.back();
+
+				table.type = type;
+				table.name = name;
+				table.key = materialKey(count, WHITE);
+				table.key2 = materialKey(count, BLACK);
+				table.piece_count = (int)piece_types.size();
+				table.has_pawns = count[WHITE][PAWN] || count[BLACK][PAWN];
+
+				table.has_unique_pieces = false;
+				for (Color c : Colors)
+				{
+					for (PieceType piece_type = PAWN; piece_type < KING; ++piece_type)
+						table.has_unique_pieces |= count[c][piece_type] == 1;
+				}
+
+				// The color with fewer pawns leads, it compresses better
+				Color lead = !count[BLACK][PAWN] || (count[WHITE][PAWN] && count[BLACK][PAWN] >= count[WHITE][PAWN]) ? WHITE : BLACK;
+				table.pawn_count[0] = count[lead][PAWN];
+				table.pawn_count[1] = count[~lead][PAWN];
+
+				table.ready = false;
+				table.valid = false;
+				table.map = nullptr;
+				tables[type] = &table;
+			}
+
+			TableMap[tables[WDL]->key] = std::make_pair(tables[WDL], tables[DTZ]);
+			TableMap[tables[WDL]->key2] = std::make_pair(tables[WDL], tables[DTZ]);
+		}
+	}
+
+	int init(const std::string &path)
+	{
+		initEncoding();
+
+		TableMap.clear();
+		Tables.clear();
+		Paths.clear();
+		MaxCardinality = 0;
+
+#ifdef _WIN32
+		const char separator = ';';
+#else
+		const char separator = ':';
+#endif
+
+		size_t start = 0;
+		while (start < path.size())
+		{
+			size_t end = path.find(separator, start);
+			if (end == std::string::npos)
+				end = path.size();
+			if (end > start)
+				Paths.push_back(path.substr(start, end - start));
+			start = end + 1;
+		}
+
+		if (Paths.empty())
+			return 0;
+
+		// Every material with the stronger side first, as the files are named
+		for (PieceType p1 = PAWN; p1 < KING; ++p1)
+		{
+			addTable({ KING, p1, KING });
+
+			for (PieceType p2 = PAWN; p2 <= p1; ++p2)
+			{
+				addTable({ KING, p1, p2, KING });
+				addTable({ KING, p1, KING, p2 });
+
+				for (PieceType p3 = PAWN; p3 < KING; ++p3)
+					addTable({ KING, p1, p2, KING, p3 });
+
+				for (PieceType p3 = PAWN; p3 <= p2; ++p3)
+				{
+					addTable({ KING, p1, p2, p3, KING });
+
+					for (PieceType p4 = PAWN; p4 <= p3; ++p4)
+					{
+						addTable({ KING, p1, p2, p3, p4, KING });
+
+						for (PieceType p5 = PAWN; p5 <= p4; ++p5)
+							addTable({ KING, p1, p2, p3, p4, p5, KING });
+
+						for (PieceType p5 = PAWN; p5 < KING; ++p5)
+							addTable({ KING, p1, p2, p3, p4, KING, p5 });
+					}
+
+					for (PieceType p4 = PAWN; p4 < KING; ++p4)
+					{
+						addTable({ KING, p1, p2, p3, KING, p4 });
+
+						for (PieceType p5 = PAWN; p5 <= p4; ++p5)
+							addTable({ KING, p1, p2, p3, KING, p4, p5 });
+					}
+				}
+
+				for (PieceType p3 = PAWN; p3 <= p1; ++p3)
+				{
+					for (PieceType p4 = PAWN; p4 <= (p1 == p3 ? p2 : p3); ++p4)
+						addTable({ KING, p1, p2, KING, p3, p4 });
+				}
+			}
+		}
+
+		return (int)Tables.size() / 2;
+	}
+
+	int maxPieces()
+	{
+		return MaxCardinality;
+	}
+
+	bool probeWdl(const Board &board, Wdl &wdl)
+	{
+		if (!canProbe(board))
+			return false;
+
+		ProbeState result = OK;
+		wdl = search(board, false, result);
+		return result != FAIL;
+	}
+
+	bool probeDtz(const Board &board, int &dtz)
+	{
+		if (!canProbe(board))
+			return false;
+
+		ProbeState result;
+		dtz = probeDtz(board, result);
+		return result != FAIL;
+	}
+
+	bool filterRootMoves(const Board &board, std::vector<Move> &moves)
+	{
+		if (!canProbe(board))
+			return false;
+
+		ProbeState result;
+		int root_dtz = probeDtz(board, result);
+		if (result == FAIL)
+			return false;
+
+		// The DTZ of each move counted from the root
+		std::vector<int> dtz(moves.size());
+		for (size_t i = 0; i < moves.size(); ++i)
+		{
+			Board board_copy = board;
+			board_copy.makeMove(moves[i]);
+
+			if (root_dtz > 0 && board_copy.isInCheck(board_copy.toMove()) && !hasLegalMove(board_copy))
+				dtz[i] = 1;
+			else if (board_copy.halfmoveClock() == 0)
+			{
+				result = OK;
+				dtz[i] = dtzBeforeZeroing(Wdl(-search(board_copy, false, result)));
+			}
+			else
+			{
+				dtz[i] = -probeDtz(board_copy, result);
+				dtz[i] += sign(dtz[i]);
+			}
+
+			if (result == FAIL)
+				return false;
+		}
+
+		std::vector<Move> kept;
+
+		if (root_dtz > 0)
+		{
+			// Zeroing as soon as possible wins before the fifty-move rule, and can't repeat
+			int best = 0xFFFF;
+			for (int value : dtz)
+			{
+				if (value > 0)
+					best = std::min(best, value);
+			}
+
+			for (size_t i = 0; i < moves.size(); ++i)
+			{
+				if (dtz[i] == best)
+					kept.push_back(moves[i]);
+			}
+		}
+		else if (root_dtz < 0)
+		{
+			// Every move loses, the search picks one unless the fifty-move rule can save the game
+			int best = 0;
+			for (int value : dtz)
+				best = std::min(best, value);
+
+			if (-best * 2 + board.halfmoveClock() < 100)
+				return true;
+
+			for (size_t i = 0; i < moves.size(); ++i)
+			{
+				if (dtz[i] == best)
+					kept.push_back(moves[i]);
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < moves.size(); ++i)
+			{
+				if (dtz[i] == 0)
+					kept.push_back(moves[i]);
+			}
+		}
+
+		if (!kept.empty())
+			moves = kept;
+		return true;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "move.h"
+#include "types.h"
+
+// Probing of Syzygy endgame tablebases: the win/draw/loss tables (.rtbw) and the distance to zeroing
+// tables (.rtbz). A table is memory mapped the first time one of its positions is probed.
+namespace Tablebase
+{
+	// The most pieces, kings included, of a table
+	const int MaxPieces = 7;
+
+	// The result for the side to move. The cursed win and the blessed loss are drawn by the
+	// fifty-move rule.
+	enum Wdl
+	{
+		WDL_LOSS = -2, WDL_BLESSED_LOSS = -1, WDL_DRAW = 0, WDL_CURSED_WIN = 1, WDL_WIN = 2
+	};
+
+	// Looks for the tables in the directories of the path, separated by ';' on Windows and by ':'
+	// elsewhere. An empty path unloads the tables. Returns the number of tables found.
+	int init(const std::string &path);
+
+	// The most pieces of the tables found, 0 if there are none
+	int maxPieces();
+
+	// The result is exact if the halfmove clock is zero. Returns false if a table is missing or the
+	// position has castling rights.
+	bool probeWdl(const Board &board, Wdl &wdl);
+
+	// The number of plies to the next capture or pawn move of the winning side: positive if the side
+	// to move wins, negative if it loses and 0 for a draw. Returns false like probeWdl.
+	bool probeDtz(const Board &board, int &dtz);
+
+	// Keeps the moves that preserve the result of the root: the winning moves that zero the
+	// halfmove clock the soonest, the drawing moves or, when losing near the fifty-move limit, the
+	// moves that delay it the most. Leaves the moves unchanged and returns false if a table is missing.
+	bool filterRootMoves(const Board &board, std::vector<Move> &moves);
+}
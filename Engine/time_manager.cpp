@@ -0,0 +1,111 @@
+#include <algorithm>
+
+#include "time_manager.h"
+
+TimeManager::TimeManager()
+{
+	startInfinite();
+}
+
+void TimeManager::startInfinite()
+{
+	_start = std::chrono::steady_clock::now();
+	_has_limit = false;
+	_adaptive = false;
+	_soft_limit = _hard_limit = std::chrono::milliseconds::max();
+	_scale = 1.0;
+	_best_move = Move();
+	_score = 0;
+	_best_move_changes = 0.0;
+}
+
+void TimeManager::startMoveTime(std::chrono::milliseconds movetime)
+{
+	startInfinite();
+	_has_limit = true;
+	_soft_limit = _hard_limit = movetime;
+}
+
+void TimeManager::startClock(std::chrono::milliseconds time, std::chrono::milliseconds increment, int moves_to_go)
+{
+	startInfinite();
+	_has_limit = true;
+	_adaptive = true;
+
+	long long usable = std::max((long long)time.count() - _Move_Overhead, 1LL);
+	int moves = moves_to_go > 0 ? std::min(moves_to_go, _Default_Moves_To_Go) : _Default_Moves_To_Go;
+
+	long long hard = (long long)(usable * _Max_Usage);
+	long long soft = std::min(usable / moves + (long long)increment.count() * 3 / 4, hard);
+
+	_soft_limit = std::chrono::milliseconds(std::max(soft, 1LL));
+	_hard_limit = std::chrono::milliseconds(std::max(std::min((long long)(soft * _Hard_Ratio), hard), 1LL));
+}
+
+void TimeManager::update(int depth, Move best_move, int score, double best_move_node_fraction)
+{
+	if (!_adaptive)
+		return;
+
+	_best_move_changes /= 2;
+	if (depth > 1 && best_move != _best_move)
+		_best_move_changes += 1.0;
+
+	// More time if the best move keeps changing
+	double instability = 1.0 + _best_move_changes / 2;
+
+	// More time if the score drops
+	double score_drop = depth > 1 ? std::max(0, std::min(_score - score, _Score_Drop)) : 0;
+	double falling = 1.0 + score_drop / _Score_Drop / 2;
+
+	// Less time if most of the effort goes into the best move, more if it is spread out
+	double effort = 1.6 - best_move_node_fraction;
+
+	_scale = std::max(_Min_Scale, std::min(instability * falling * effort, _Max_Scale));
+	_best_move = best_move;
+	_score = score;
+}
+
+std::chrono::milliseconds TimeManager::elapsed() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start);
+}
+
+bool TimeManager::hasLimit() const
+{
+	return _has_limit;
+}
+
+bool TimeManager::softLimitReached() const
+{
+	// The next iteration takes about as long as all the previous ones, so it is not started if it
+	// would most likely end after the soft limit
+	return _adaptive && elapsed().count() >= softLimit().count() * _Iteration_Share;
+}
+
+bool TimeManager::hardLimitReached(std::chrono::milliseconds elapsed) const
+{
+	return _has_limit && elapsed >= _hard_limit;
+}
+
+std::chrono::milliseconds TimeManager::softLimit() const
+{
+	if (!_has_limit)
+		return std::chrono::milliseconds::max();
+
+	return std::min(std::chrono::milliseconds((long long)(_soft_limit.count() * _scale)), _hard_limit);
+}
+
+std::chrono::milliseconds TimeManager::hardLimit() const
+{
+	return _hard_limit;
+}
+
+const int TimeManager::_Move_Overhead = 30;
+const int TimeManager::_Default_Moves_To_Go = 30;
+const double TimeManager::_Hard_Ratio = 4.0;
+const double TimeManager::_Max_Usage = 0.8;
+const double TimeManager::_Min_Scale = 0.4;
+const double TimeManager::_Max_Scale = 2.5;
+const int TimeManager::_Score_Drop = 100;
+const double TimeManager::_Iteration_Share = 0.5;
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+
+#include "move.h"
+#include "types.h"
+
+// Decides how long to think on a move. The soft limit is checked between the iterations of the
+// search and is scaled by the stability of the best move, the hard limit aborts the search.
+class TimeManager
+{
+public:
+	TimeManager();
+
+	// No time limit
+	void startInfinite();
+
+	// Search exactly the given time
+	void startMoveTime(std::chrono::milliseconds movetime);
+
+	// Budget from the remaining time, the increment and the number of moves to the next time
+	// control, where moves_to_go is 0 if unknown
+	void startClock(std::chrono::milliseconds time, std::chrono::milliseconds increment, int moves_to_go);
+
+	// Updates the scaling of the soft limit after a completed iteration. The node fraction is the
+	// share of the root nodes of the iteration spent on the best move.
+	void update(int depth, Move best_move, int score, double best_move_node_fraction);
+
+	std::chrono::milliseconds elapsed() const;
+
+	bool hasLimit() const;
+
+	// True if there is no time for another iteration, never true for a fixed move time
+	bool softLimitReached() const;
+	bool hardLimitReached(std::chrono::milliseconds elapsed) const;
+
+	std::chrono::milliseconds softLimit() const;
+	std::chrono::milliseconds hardLimit() const;
+
+private:
+	std::chrono::steady_clock::time_point _start;
+
+	bool _has_limit;
+
+	// False for a fixed move time, the soft limit is only scaled when playing with a clock
+	bool _adaptive;
+
+	std::chrono::milliseconds _soft_limit;
+	std::chrono::milliseconds _hard_limit;
+
+	// Multiplier of the soft limit, set after each iteration
+	double _scale;
+
+	Move _best_move;
+	int _score;
+
+	// Number of recent best move changes, halved after each iteration
+	double _best_move_changes;
+
+	// Time kept in reserve for the communication with the GUI
+	const static int _Move_Overhead;
+
+	// The assumed number of moves left if the time control doesn't specify it
+	const static int _Default_Moves_To_Go;
+
+	// The hard limit is this many times the soft limit, but at most this share of the remaining time
+	const static double _Hard_Ratio;
+	const static double _Max_Usage;
+
+	// The soft limit is scaled by at most this much either way
+	const static double _Min_Scale;
+	const static double _Max_Scale;
+
+	// Score drop (in centipawns) that gives the maximum extension
+	const static int _Score_Drop;
+
+	// No new iteration is started after this share of the soft limit
+	const static double _Iteration_Share;
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <xmmintrin.h>
+
 #include "move.h"
 
 class TranspositionTable
@@ -12,6 +15,21 @@ public:
 	TranspositionTable(const TranspositionTable &other) = delete;
 	TranspositionTable& operator=(const TranspositionTable &other) = delete;
 
+	struct Entry
+	{
+		Entry(u64 hash, int depth, int score, Move move, ScoreType nodeType) :
+			hash(hash), depth(depth), score(score), move(move), nodeType(nodeType), valid(true) {}
+
+		Entry() : valid(false) {}
+
+		u64 hash;
+		int depth;
+		int score;
+		Move move;
+		ScoreType nodeType;
+		bool valid;
+	};
+
 	struct Stat
 	{
 		u64 pv_node_hits = 0;
@@ -38,56 +56,55 @@ public:
 	{
 		Entry *entry = _getEntry(hash);
 
-		if (!entry->valid)
-		{
-			*entry = Entry(hash, depth, score, move, nodeType);
-			++_entry_count;
-		}
-		else if (entry->depth < depth)
+		if (!entry->valid || entry->depth <= depth)
 			*entry = Entry(hash, depth, score, move, nodeType);
 		//else if (entry->hash != hash)
 		//	++_stats.failed_inserts;
 	}
 
-	std::pair<int, Move> probe(u64 hash, int depth, int alpha, int beta)
+	// The bound of the window the entry proves, if it was searched deep enough: beta for a fail high and
+	// alpha for a fail low, SCORE_INVALID otherwise
+	int cutoffScore(const Entry &entry, int depth, int alpha, int beta) const
 	{
-		ASSERT(hash != 0);
+		int score = SCORE_INVALID;
 
-		std::pair<int, Move> pair = std::make_pair(SCORE_INVALID, Move());
-		Entry *entry = _getEntry(hash);
-
-		if (entry->hash == hash)
+		if ((entry.nodeType == LOWER_BOUND || entry.nodeType == EXACT) && beta <= entry.score)
+		{
+			++_stats.cut_node_hits;
+			score = beta;
+		}
+		else if ((entry.nodeType == UPPER_BOUND || entry.nodeType == EXACT) && entry.score <= alpha)
 		{
-			if ((entry->nodeType == LOWER_BOUND || entry->nodeType == EXACT) && beta <= entry->score)
-			{
-				++_stats.cut_node_hits;
-				pair = std::make_pair(beta, entry->move);
-			}
-			else if ((entry->nodeType == UPPER_BOUND || entry->nodeType == EXACT) && entry->score <= alpha)
-			{
-				++_stats.all_node_hits;
-				pair = std::make_pair(alpha, Move());
-			}
-			else if (entry->nodeType == EXACT)
-			{
-				++_stats.pv_node_hits;
-				pair = std::make_pair(entry->score, entry->move);
-			}
-
-			if (entry->depth < depth)
-				pair.first = SCORE_INVALID;
+			++_stats.all_node_hits;
+			score = alpha;
 		}
+		else if (entry.nodeType == EXACT)
+			++_stats.pv_node_hits;
 
-		return pair;
+		return entry.depth < depth ? SCORE_INVALID : score;
+	}
+
+	// Copies the entry of the position without clipping the score to the window, returns false if there is none
+	bool probeEntry(u64 hash, Entry &entry)
+	{
+		const Entry *e = _getEntry(hash);
+		if (!e->valid || e->hash != hash)
+			return false;
+
+		entry = *e;
+		return true;
+	}
+
+	// Loads the bucket of the position into the cache, so that a later probe doesn't wait for memory
+	void prefetch(u64 hash) const
+	{
+		_mm_prefetch((const char *)&_entries[hash % _size], _MM_HINT_T0);
 	}
 
 	void clear()
 	{
 		if (_entries != nullptr)
-		{
 			std::memset(_entries, 0, _size * sizeof(Entry));
-			_entry_count = 0;
-		}
 	}
 
 	const Stat *getStats() const
@@ -95,33 +112,31 @@ public:
 		return &_stats;
 	}
 
-	double usage() const
+	// The used share of the table in permill, estimated from the first entries. The table is cleared
+	// before each search, so every valid entry belongs to the current search.
+	int hashfull() const
 	{
-		return (double)_entry_count / (double)_size;
+		size_t sample = std::min(_size, (size_t)_Hashfull_Sample);
+		if (sample == 0)
+			return 0;
+
+		size_t used = 0;
+		for (size_t i = 0; i < sample; ++i)
+		{
+			if (_entries[i].valid)
+				++used;
+		}
+		return (int)(used * 1000 / sample);
 	}
 
 private:
-	struct Entry
-	{
-		Entry(u64 hash, int depth, int score, Move move, ScoreType nodeType) :
-			hash(hash), depth(depth), score(score), move(move), nodeType(nodeType), valid(true) {}
-
-		Entry() : valid(false) {}
-
-		u64 hash;
-		int depth;
-		int score;
-		Move move;
-		ScoreType nodeType;
-		bool valid;
-	};
-
 	Entry * _getEntry(u64 hash)
 	{
 		return &_entries[hash % _size];
 	}
 
-	size_t _size;
+	size_t _size = 0;
 	Entry *_entries = nullptr;
-	size_t _entry_count = 0;
+
+	const static int _Hashfull_Sample = 1000;
 };
\ No newline at end of file
@@ -0,0 +1,554 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "evaluation.h"
+#include "moveselect.h"
+#include "tuner.h"
+
+namespace Tuner
+{
+	// Every tunable weight gets an index in a flat parameter vector, the blocks follow each other in this order
+	enum ParamIndex
+	{
+		PARAM_PIECE_VALUE = 0,											// PAWN..QUEEN
+		PARAM_MOBILITY = PARAM_PIECE_VALUE + 5,							// KNIGHT..QUEEN, 32 entries each
+		PARAM_TEMPO_BONUS = PARAM_MOBILITY + 4 * 32,
+		PARAM_PAWN_ISLANDS = PARAM_TEMPO_BONUS + 1,
+		PARAM_PASSED_PAWN = PARAM_PAWN_ISLANDS + 5,
+		PARAM_DOUBLED_PAWN = PARAM_PASSED_PAWN + 8,
+		PARAM_ISOLATED_PAWN = PARAM_DOUBLED_PAWN + 8,
+		PARAM_HALF_OPEN_FILE_BONUS = PARAM_ISOLATED_PAWN + 8,
+		PARAM_OPEN_FILE_BONUS = PARAM_HALF_OPEN_FILE_BONUS + 1,
+		PARAM_KING_ATTACKS = PARAM_OPEN_FILE_BONUS + 1,
+		PARAM_PIECE_SQUARE = PARAM_KING_ATTACKS + 200,
+		PARAM_NB = PARAM_PIECE_SQUARE + PIECE_TYPE_NB * SQUARE_NB
+	};
+
+	struct Param
+	{
+		double mg;
+		double eg;
+
+		// The endgame value is not a separate weight but always half of the middlegame value (KingAttacks)
+		bool linked;
+	};
+
+	// A nonzero coefficient of a parameter in the evaluation of a position (white count - black count)
+	struct Term
+	{
+		unsigned short index;
+		short coeff;
+	};
+
+	struct Entry
+	{
+		size_t begin;
+		unsigned count;
+		int phase;
+		float result;
+
+		// The part of the evaluation not covered by the tuned parameters
+		float residual;
+	};
+
+	struct Dataset
+	{
+		std::vector<Entry> entries;
+		std::vector<Term> terms;
+	};
+
+	static int _threadCount(const Settings &settings)
+	{
+		if (settings.threads > 0)
+			return settings.threads;
+		return std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	// Runs f(thread_index, begin, end) on thread_count threads over the range [begin, end)
+	template <typename Func>
+	static void _parallelFor(size_t begin, size_t end, int thread_count, Func f)
+	{
+		std::vector<std::thread> threads;
+		size_t chunk = (end - begin + thread_count - 1) / thread_count;
+
+		for (int i = 0; i < thread_count; ++i)
+		{
+			size_t b = begin + i * chunk;
+			size_t e = std::min(end, b + chunk);
+			if (b >= e)
+				break;
+			threads.emplace_back(f, i, b, e);
+		}
+
+		for (std::thread &thread : threads)
+			thread.join();
+	}
+
+	// Calls f(index, mg, eg) for every tuned weight of the parameter struct, eg is null for linked weights
+	template <typename Func>
+	static void _forEachWeight(Evaluation::Params &p, Func f)
+	{
+		for (PieceType piece_type = PAWN; piece_type <= QUEEN; ++piece_type)
+			f(PARAM_PIECE_VALUE + piece_type, p.PieceValue[piece_type].mg, &p.PieceValue[piece_type].eg);
+
+		for (PieceType piece_type = KNIGHT; piece_type <= QUEEN; ++piece_type)
+			for (int i = 0; i < 32; ++i)
+				f(PARAM_MOBILITY + (piece_type - KNIGHT) * 32 + i, p.Mobility[piece_type][i].mg, &p.Mobility[piece_type][i].eg);
+
+		f(PARAM_TEMPO_BONUS, p.TempoBonus.mg, &p.TempoBonus.eg);
+
+		for (int i = 0; i < 5; ++i)
+			f(PARAM_PAWN_ISLANDS + i, p.PawnIslands[i].mg, &p.PawnIslands[i].eg);
+
+		for (int i = 0; i < 8; ++i)
+		{
+			f(PARAM_PASSED_PAWN + i, p.PassedPawn[i].mg, &p.PassedPawn[i].eg);
+			f(PARAM_DOUBLED_PAWN + i, p.DoubledPawn[i].mg, &p.DoubledPawn[i].eg);
+			f(PARAM_ISOLATED_PAWN + i, p.IsolatedPawn[i].mg, &p.IsolatedPawn[i].eg);
+		}
+
+		f(PARAM_HALF_OPEN_FILE_BONUS, p.HalfOpenFileBonus.mg, &p.HalfOpenFileBonus.eg);
+		f(PARAM_OPEN_FILE_BONUS, p.OpenFileBonus.mg, &p.OpenFileBonus.eg);
+
+		for (int i = 0; i < 200; ++i)
+			f(PARAM_KING_ATTACKS + i, p.KingAttacks[i], (int *)nullptr);
+
+		for (PieceType piece_type = PAWN; piece_type < PIECE_TYPE_NB; ++piece_type)
+			for (Square square : Squares)
+				f(PARAM_PIECE_SQUARE + piece_type * SQUARE_NB + square,
+					p.PieceSquareTable[piece_type][0][square], &p.PieceSquareTable[piece_type][1][square]);
+	}
+
+	static void _initParams(const Evaluation::Params &initial, std::vector<Param> &params)
+	{
+		Evaluation::Params p = initial;
+		params.assign(PARAM_NB, Param{ 0.0, 0.0, false });
+
+		_forEachWeight(p, [&](int index, int &mg, int *eg) {
+			params[index] = Param{ (double)mg, eg ? (double)*eg : 0.0, eg == nullptr };
+		});
+	}
+
+	// The tuned weights rounded into a copy of the initial parameters, the untuned fields are kept
+	static Evaluation::Params _toParams(const Evaluation::Params &initial, const std::vector<Param> &params)
+	{
+		Evaluation::Params p = initial;
+
+		_forEachWeight(p, [&](int index, int &mg, int *eg) {
+			mg = (int)std::round(params[index].mg);
+			if (eg)
+				*eg = (int)std::round(params[index].eg);
+		});
+
+		return p;
+	}
+
+	static void _addTerm(std::vector<Term> &terms, int index, const int (&count)[COLOR_NB])
+	{
+		int coeff = count[WHITE] - count[BLACK];
+		if (coeff != 0)
+			terms.push_back(Term{ (unsigned short)index, (short)coeff });
+	}
+
+	static void _traceTerms(const Evaluation::Trace &t, std::vector<Term> &terms)
+	{
+		for (PieceType piece_type = PAWN; piece_type <= QUEEN; ++piece_type)
+			_addTerm(terms, PARAM_PIECE_VALUE + piece_type, t.piece_value[piece_type]);
+
+		for (PieceType piece_type = KNIGHT; piece_type <= QUEEN; ++piece_type)
+			for (int i = 0; i < 32; ++i)
+				_addTerm(terms, PARAM_MOBILITY + (piece_type - KNIGHT) * 32 + i, t.mobility[piece_type][i]);
+
+		_addTerm(terms, PARAM_TEMPO_BONUS, t.tempo_bonus);
+
+		for (int i = 0; i < 5; ++i)
+			_addTerm(terms, PARAM_PAWN_ISLANDS + i, t.pawn_islands[i]);
+
+		for (int i = 0; i < 8; ++i)
+		{
+			_addTerm(terms, PARAM_PASSED_PAWN + i, t.passed_pawn[i]);
+			_addTerm(terms, PARAM_DOUBLED_PAWN + i, t.doubled_pawn[i]);
+			_addTerm(terms, PARAM_ISOLATED_PAWN + i, t.isolated_pawn[i]);
+		}
+
+		_addTerm(terms, PARAM_HALF_OPEN_FILE_BONUS, t.half_open_file_bonus);
+		_addTerm(terms, PARAM_OPEN_FILE_BONUS, t.open_file_bonus);
+
+		for (int i = 0; i < 200; ++i)
+			_addTerm(terms, PARAM_KING_ATTACKS + i, t.king_attacks[i]);
+
+		for (PieceType piece_type = PAWN; piece_type < PIECE_TYPE_NB; ++piece_type)
+			for (Square square : Squares)
+				_addTerm(terms, PARAM_PIECE_SQUARE + piece_type * SQUARE_NB + square, t.piece_square[piece_type][square]);
+	}
+
+	// The evaluation from white's point of view, computed from the trace and the current parameters
+	static double _linearEval(const Entry &entry, const Term *terms, const std::vector<Param> &params)
+	{
+		double mg = 0.0, eg = 0.0;
+
+		for (unsigned i = 0; i < entry.count; ++i)
+		{
+			const Param &param = params[terms[i].index];
+			mg += terms[i].coeff * param.mg;
+			eg += terms[i].coeff * (param.linked ? param.mg / 2 : param.eg);
+		}
+
+		return (mg * (256 - entry.phase) + eg * entry.phase) / 256 + entry.residual;
+	}
+
+	static double _sigmoid(double K, double eval)
+	{
+		return 1.0 / (1.0 + std::pow(10.0, -K * eval / 400.0));
+	}
+
+	// Quiescence search that also returns the position at the end of the principal variation
+	template <Color toMove>
+	static int _quiescence(const Board &board, int alpha, int beta, Board &leaf)
+	{
+		int stand_pat = Evaluation::evaluate<toMove>(board);
+		leaf = board;
+
+		if (stand_pat >= beta)
+			return beta;
+
+		if (alpha < stand_pat)
+			alpha = stand_pat;
+
+		MoveSelect::MoveSelector<toMove, true> mg(board);
+		for (; !mg.end(); mg.next())
+		{
+			Board board_copy = board;
+			if (!board_copy.makeMove(mg.curr()))
+				continue;
+
+			Board child_leaf;
+			int score = -_quiescence<~toMove>(board_copy, -beta, -alpha, child_leaf);
+			if (score >= beta)
+			{
+				leaf = child_leaf;
+				return beta;
+			}
+			if (score > alpha)
+			{
+				alpha = score;
+				leaf = child_leaf;
+			}
+		}
+
+		return alpha;
+	}
+
+	static bool _parseLine(const std::string &line, Board &board, float &result)
+	{
+		std::stringstream ss(line);
+		std::stringstream fen;
+		std::string token;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			if (!(ss >> token))
+				return false;
+			fen << token << " ";
+		}
+
+		std::vector<std::string> rest;
+		while (ss >> token)
+			rest.push_back(token);
+
+		// Halfmove clock and fullmove number are optional
+		if (rest.size() >= 2 && std::isdigit(rest[0][0]) && std::isdigit(rest[1][0]) && rest[0].find('-') == std::string::npos)
+		{
+			fen << rest[0] << " " << rest[1];
+			rest.erase(rest.begin(), rest.begin() + 2);
+		}
+		else
+			fen << "0 1";
+
+		bool found = false;
+		for (std::string r : rest)
+		{
+			r.erase(std::remove_if(r.begin(), r.end(), [](char c) { return c == '"' || c == ';' || c == '[' || c == ']'; }), r.end());
+
+			if (r == "1-0" || r == "1.0")
+				result = 1.0f, found = true;
+			else if (r == "0-1" || r == "0.0")
+				result = 0.0f, found = true;
+			else if (r == "1/2-1/2" || r == "0.5")
+				result = 0.5f, found = true;
+		}
+
+		if (!found)
+			return false;
+
+		try
+		{
+			board = Board::fromFen(fen.str());
+		}
+		catch (FenParseError e)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	static void _loadChunk(const std::vector<std::string> &lines, size_t begin, size_t end,
+		const std::vector<Param> &params, Dataset &data)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			Board board, leaf;
+			float result;
+
+			if (!_parseLine(lines[i], board, result))
+				continue;
+
+			if (board.toMove() == WHITE)
+				_quiescence<WHITE>(board, -SCORE_INFINITY, SCORE_INFINITY, leaf);
+			else
+				_quiescence<BLACK>(board, -SCORE_INFINITY, SCORE_INFINITY, leaf);
+
+			if (leaf.isDraw() || leaf.isInCheck(leaf.toMove()))
+				continue;
+
+			Evaluation::Trace trace;
+			int eval = Evaluation::evaluate<WHITE, true>(leaf, Evaluation::activeParams(), &trace);
+
+			Entry entry;
+			entry.begin = data.terms.size();
+			_traceTerms(trace, data.terms);
+			entry.count = (unsigned)(data.terms.size() - entry.begin);
+			entry.phase = leaf.phase();
+			entry.result = result;
+			entry.residual = 0.0f;
+			entry.residual = (float)(eval - _linearEval(entry, &data.terms[entry.begin], params));
+
+			data.entries.push_back(entry);
+		}
+	}
+
+	static void _loadPositions(const std::string &in_file, int thread_count, const std::vector<Param> &params, Dataset &data,
+		const std::function<void(const std::string&)> &output)
+	{
+		const static size_t ChunkSize = 1 << 20;
+
+		std::ifstream in(in_file);
+		if (!in)
+		{
+			output("Error opening file \"" + in_file + "\"");
+			return;
+		}
+
+		std::vector<std::string> lines;
+		lines.reserve(ChunkSize);
+
+		std::vector<Dataset> partial(thread_count);
+		std::string line;
+		bool eof = false;
+
+		while (!eof)
+		{
+			lines.clear();
+			while (lines.size() < ChunkSize && !(eof = !std::getline(in, line)))
+				lines.push_back(line);
+
+			for (Dataset &d : partial)
+			{
+				d.entries.clear();
+				d.terms.clear();
+			}
+
+			_parallelFor(0, lines.size(), thread_count, [&](int thread, size_t begin, size_t end) {
+				_loadChunk(lines, begin, end, params, partial[thread]);
+			});
+
+			for (const Dataset &d : partial)
+			{
+				size_t offset = data.terms.size();
+				data.terms.insert(data.terms.end(), d.terms.begin(), d.terms.end());
+				for (Entry entry : d.entries)
+				{
+					entry.begin += offset;
+					data.entries.push_back(entry);
+				}
+			}
+
+			output("info string loaded " + std::to_string(data.entries.size()) + " positions");
+		}
+	}
+
+	static double _totalError(const Dataset &data, const std::vector<Param> &params, double K, int thread_count)
+	{
+		std::vector<double> errors(thread_count, 0.0);
+
+		_parallelFor(0, data.entries.size(), thread_count, [&](int thread, size_t begin, size_t end) {
+			double sum = 0.0;
+			for (size_t i = begin; i < end; ++i)
+			{
+				const Entry &entry = data.entries[i];
+				double diff = entry.result - _sigmoid(K, _linearEval(entry, &data.terms[entry.begin], params));
+				sum += diff * diff;
+			}
+			errors[thread] = sum;
+		});
+
+		double sum = 0.0;
+		for (double e : errors)
+			sum += e;
+
+		return sum / data.entries.size();
+	}
+
+	// Finds the scaling constant of the sigmoid which best fits the current evaluation to the results
+	static double _findK(const Dataset &data, const std::vector<Param> &params, int thread_count)
+	{
+		double best = 1.0, step = 0.1;
+		double best_error = _totalError(data, params, best, thread_count);
+
+		for (int round = 0; round < 3; ++round, step /= 10.0)
+		{
+			double center = best;
+			for (int i = -10; i <= 10; ++i)
+			{
+				double K = center + i * step;
+				if (K <= 0.0 || i == 0)
+					continue;
+
+				double error = _totalError(data, params, K, thread_count);
+				if (error < best_error)
+				{
+					best_error = error;
+					best = K;
+				}
+			}
+		}
+
+		return best;
+	}
+
+	static void _computeGradient(const Dataset &data, size_t begin, size_t end, const std::vector<Param> &params,
+		double K, int thread_count, std::vector<double> &gradient)
+	{
+		std::vector<std::vector<double> > partial(thread_count, std::vector<double>(2 * PARAM_NB, 0.0));
+
+		_parallelFor(begin, end, thread_count, [&](int thread, size_t b, size_t e) {
+			std::vector<double> &grad = partial[thread];
+
+			for (size_t i = b; i < e; ++i)
+			{
+				const Entry &entry = data.entries[i];
+				const Term *terms = &data.terms[entry.begin];
+
+				double s = _sigmoid(K, _linearEval(entry, terms, params));
+				double d = (s - entry.result) * s * (1.0 - s);
+				double mg_factor = d * (256 - entry.phase) / 256.0;
+				double eg_factor = d * entry.phase / 256.0;
+
+				for (unsigned j = 0; j < entry.count; ++j)
+				{
+					int index = terms[j].index;
+					if (params[index].linked)
+						grad[2 * index] += terms[j].coeff * (mg_factor + eg_factor / 2);
+					else
+					{
+						grad[2 * index] += terms[j].coeff * mg_factor;
+						grad[2 * index + 1] += terms[j].coeff * eg_factor;
+					}
+				}
+			}
+		});
+
+		// The constant factors of the derivative of the mean squared error
+		double scale = 2.0 * K * std::log(10.0) / 400.0 / (end - begin);
+
+		gradient.assign(2 * PARAM_NB, 0.0);
+		for (const std::vector<double> &grad : partial)
+			for (int i = 0; i < 2 * PARAM_NB; ++i)
+				gradient[i] += grad[i] * scale;
+	}
+
+	void tune(const std::string &in_file, const Settings &settings, const std::function<void(const std::string&)> &output)
+	{
+		const static double Beta1 = 0.9;
+		const static double Beta2 = 0.999;
+		const static double Epsilon = 1e-8;
+
+		int thread_count = _threadCount(settings);
+
+		// Tuning continues from the loaded parameters if there are any
+		const Evaluation::Params &initial = Evaluation::activeParams();
+
+		std::vector<Param> params;
+		_initParams(initial, params);
+
+		Dataset data;
+		_loadPositions(in_file, thread_count, params, data, output);
+
+		if (data.entries.empty())
+		{
+			output("No positions to tune on");
+			return;
+		}
+
+		double K = _findK(data, params, thread_count);
+		std::ostringstream initial_error;
+		initial_error << "info string K = " << K << ", initial error = " << std::setprecision(8) << _totalError(data, params, K, thread_count);
+		output(initial_error.str());
+
+		// Adam optimizer state
+		std::vector<double> m(2 * PARAM_NB, 0.0), v(2 * PARAM_NB, 0.0), gradient;
+		int step = 0;
+
+		for (int epoch = 1; epoch <= settings.epochs; ++epoch)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			for (size_t begin = 0; begin < data.entries.size(); begin += settings.batch_size)
+			{
+				size_t end = std::min(data.entries.size(), begin + settings.batch_size);
+				_computeGradient(data, begin, end, params, K, thread_count, gradient);
+
+				++step;
+				for (int i = 0; i < 2 * PARAM_NB; ++i)
+				{
+					m[i] = Beta1 * m[i] + (1 - Beta1) * gradient[i];
+					v[i] = Beta2 * v[i] + (1 - Beta2) * gradient[i] * gradient[i];
+
+					double m_hat = m[i] / (1 - std::pow(Beta1, step));
+					double v_hat = v[i] / (1 - std::pow(Beta2, step));
+					double delta = settings.learning_rate * m_hat / (std::sqrt(v_hat) + Epsilon);
+
+					if (i % 2 == 0)
+						params[i / 2].mg -= delta;
+					else
+						params[i / 2].eg -= delta;
+				}
+			}
+
+			auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+			std::ostringstream progress;
+			progress << "info string epoch " << epoch << " error " << std::setprecision(8) << _totalError(data, params, K, thread_count)
+				<< " time " << elapsed.count() << " ms";
+			output(progress.str());
+		}
+
+		try
+		{
+			Evaluation::saveParams(_toParams(initial, params), settings.out_file);
+			output("info string parameters written to " + settings.out_file);
+		}
+		catch (Evaluation::ParamsParseError e)
+		{
+			output("Error creating file \"" + settings.out_file + "\"");
+		}
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+namespace Tuner
+{
+	struct Settings
+	{
+		int epochs = 100;
+		int batch_size = 16384;
+		double learning_rate = 1.0;
+
+		// Number of worker threads, 0 means one per hardware thread
+		int threads = 0;
+
+		std::string out_file = "evaluation_params.txt";
+	};
+
+	// Texel-style tuning of the evaluation weights, starting from the active parameters. The input file contains
+	// one labelled position per line: a FEN/EPD followed by the game result ("1-0", "0-1", "1/2-1/2" or "[1.0]",
+	// "[0.5]", "[0.0]"). The result is written as a parameter file which can be loaded with Evaluation::loadParams.
+	// The progress and the errors are passed to output line by line.
+	void tune(const std::string &in_file, const Settings &settings, const std::function<void(const std::string&)> &output);
+}
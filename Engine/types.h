@@ -100,7 +100,7 @@ Color operator++(Color &color);
 
 struct Score
 {
-	explicit Score(int mg = 0, int eg = 0) : mg(mg), eg(eg) {}
+	constexpr explicit Score(int mg = 0, int eg = 0) : mg(mg), eg(eg) {}
 
 	int mg;
 	int eg;
@@ -116,8 +116,13 @@ Score operator*(const Score &score, double d);
 
 enum ScoreConstant
 {
+	SCORE_BAD_CAPTURE = -(1 << 20),
+	SCORE_QUIET = -(1 << 16),
 	SCORE_DRAW = 0,
+	SCORE_COUNTER_MOVE = 140,
 	SCORE_KILLER = 150,
+	SCORE_KNOWN_WIN = 10000,
+	SCORE_TABLEBASE_WIN = 20000,
 	SCORE_MIN_MATE = 32667,
 	SCORE_MAX_MATE = 32767,
 	SCORE_INFINITY = 32768,
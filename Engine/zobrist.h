@@ -7,6 +7,9 @@ namespace Zobrist
 	void initZobristHashing();
 	u64 getBoardHash(const Board & board);
 
+	// The key of the position in Polyglot opening books
+	u64 polyglotKey(const Board & board);
+
 	extern u64 PiecePositionHash[COLOR_NB][PIECE_TYPE_NB][SQUARE_NB];
 	extern u64 BlackMovesHash;
 	extern u64 CastlingRightsHash[16];
@@ -1,12 +1,18 @@
 #include "attacks.h"
+#include "bitbase.h"
 #include "board.h"
+#include "book.h"
 #include "bitboard_iterator.h"
 #include "epd.h"
 #include "perft.h"
 #include "zobrist.h"
 #include "config.h"
+#include "match.h"
 #include "search.h"
 #include "search_event_handler.h"
+#include "tablebase.h"
+#include "tuner.h"
+#include "uci_io.h"
 
 #include <iostream>
 #include <fstream>
@@ -22,6 +28,7 @@ void perftReceived(Board board, int depth, std::vector<Move> moves, bool per_mov
 void printPerftRes(const Perft::PerftResult &res);
 
 void runTest(const std::string &in_file, int depth, const std::string &out_file = "");
+void runBench(int depth, size_t hash_size);
 
 int main(int argc, char *argv[])
 {
@@ -32,26 +39,53 @@ int main(int argc, char *argv[])
 	initObstructedTable();
 	Zobrist::initZobristHashing();
 	initDistanceTable();
+	Bitbase::init();
 
 	Board board;
 	bool debug = false;
 
-	std::ofstream log("log.txt");
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (std::string(argv[i]) == "-evalfile")
+			setoptionReceived(search, "EvalFile", argv[i + 1]);
+	}
+
+	// Stop and ponderhit are handled right away on the reader thread, the search polls the flags
+	UciIo::start([&search](const std::string &line)
+	{
+		std::istringstream iss(line);
+		std::string token;
+		iss >> token;
+		if (token == "stop")
+			search.stopSearch();
+		else if (token == "ponderhit")
+			search.setPonder(false);
+		else
+			return false;
+		return true;
+	}, "log.txt");
 
 	std::string line;
 	auto   running = true;
-	while (running && getline(std::cin, line))
+	while (running && UciIo::nextCommand(line))
 	{
-		log << line << std::endl;
-
 		std::istringstream iss(line);
 		std::string        token;
 		iss >> std::skipws >> token;
 		if (token == "uci")
 		{
-			std::cout << "option name Hash type spin min 2 max 4096 default 32" << std::endl;
-			std::cout << "option name Ponder" << std::endl;
-			std::cout << "uciok" << std::endl;
+			UciIo::send("option name Hash type spin min 2 max 4096 default 32");
+			UciIo::send("option name Ponder");
+			UciIo::send("option name MultiPV type spin min 1 max 256 default 1");
+			UciIo::send("option name EvalFile type string default <empty>");
+			UciIo::send("option name OwnBook type check default false");
+			UciIo::send("option name BookFile type string default <empty>");
+			UciIo::send("option name BookBestMove type check default false");
+			UciIo::send("option name SyzygyPath type string default <empty>");
+			UciIo::send("option name SyzygyProbeLimit type spin min 0 max 7 default 7");
+			UciIo::send("option name InfoInterval type spin min 0 max 60000 default 1000");
+			UciIo::send("option name CurrmoveDelay type spin min 0 max 60000 default 3000");
+			UciIo::send("uciok");
 		}
 		else if (token == "debug")
 		{
@@ -60,7 +94,7 @@ int main(int argc, char *argv[])
 		}
 		else if (token == "isready")
 		{
-			std::cout << "readyok" << std::endl;
+			UciIo::send("readyok");
 		}
 		else if (token == "setoption")
 		{
@@ -92,18 +126,34 @@ int main(int argc, char *argv[])
 				moves.push_back(token);
 
 			board = Board::fromFen(fen);
-			for (std::string move : moves)
+
+			// Positions before an irreversible move can't be repeated, so they are left out of the history
+			std::vector<u64> history;
+			for (std::string str : moves)
 			{
-				board.makeMove(Move::fromAlgebraic(board, move));
+				Move move = Move::fromAlgebraic(board, str);
+				if (RepetitionTable::isIrreversible(move))
+					history.clear();
+				else
+					history.push_back(board.hash());
+
+				board.makeMove(move);
 			}
+			search.setGameHistory(history);
 		}
 		else if (token == "go")
 		{
 			long long clock_left[COLOR_NB] = { -1, -1 };
 			search.setInfinite(false);
 			search.unsetMaxDepth();
+			search.unsetMaxNodes();
+			search.unsetMate();
+			search.setSearchMoves(std::vector<Move>());
 			search.unsetClock(WHITE);
 			search.unsetClock(BLACK);
+			search.setIncrement(WHITE, std::chrono::milliseconds(0));
+			search.setIncrement(BLACK, std::chrono::milliseconds(0));
+			search.setMovesToGo(0);
 			search.unsetMoveTime();
 			search.setPonder(false);
 
@@ -116,6 +166,39 @@ int main(int argc, char *argv[])
 					iss >> depth;
 					search.setMaxDepth(depth);
 				}
+				else if (token == "nodes")
+				{
+					u64 nodes;
+					iss >> nodes;
+					search.setMaxNodes(nodes);
+				}
+				else if (token == "mate")
+				{
+					int moves;
+					iss >> moves;
+					search.setMate(moves);
+				}
+				else if (token == "searchmoves")
+				{
+					// The moves continue until the next token that is not a move
+					std::vector<Move> moves;
+					std::streampos pos = iss.tellg();
+					while (iss >> token)
+					{
+						try
+						{
+							moves.push_back(Move::fromAlgebraic(board, token));
+							pos = iss.tellg();
+						}
+						catch (MoveParseError e)
+						{
+							iss.clear();
+							iss.seekg(pos);
+							break;
+						}
+					}
+					search.setSearchMoves(moves);
+				}
 				else if (token == "movetime")
 				{
 					long long movetime;
@@ -134,6 +217,24 @@ int main(int argc, char *argv[])
 					iss >> clock;
 					search.setClock(BLACK, std::chrono::milliseconds(clock));
 				}
+				else if (token == "winc")
+				{
+					long long increment;
+					iss >> increment;
+					search.setIncrement(WHITE, std::chrono::milliseconds(increment));
+				}
+				else if (token == "binc")
+				{
+					long long increment;
+					iss >> increment;
+					search.setIncrement(BLACK, std::chrono::milliseconds(increment));
+				}
+				else if (token == "movestogo")
+				{
+					int moves_to_go;
+					iss >> moves_to_go;
+					search.setMovesToGo(moves_to_go);
+				}
 
 			if (search.getPonder())
 			{
@@ -161,7 +262,7 @@ int main(int argc, char *argv[])
 		}
 		else if (token == "eval")
 		{
-			std::cout << Evaluation::evaluate<WHITE>(board) << std::endl;
+			UciIo::send(std::to_string(Evaluation::evaluate<WHITE>(board)));
 		}
 		else if (token == "perft")
 		{
@@ -211,6 +312,17 @@ int main(int argc, char *argv[])
 			iss >> filename;
 			Perft::perft(filename);
 		}
+		else if (token == "makebook")
+		{
+			std::string games_file, book_file;
+			int plies = 16;
+			iss >> games_file >> book_file >> plies;
+
+			if (Book::build(games_file, book_file, plies))
+				UciIo::send("Book written to " + book_file);
+			else
+				UciIo::send("Error creating book from " + games_file);
+		}
 		else if (token == "run_test")
 		{
 			std::string filename;
@@ -220,11 +332,103 @@ int main(int argc, char *argv[])
 
 			runTest(filename, depth);
 		}
+		else if (token == "bench")
+		{
+			int depth = 10;
+			size_t hash_size = DEFAULT_HASH_TABLE_SIZE;
+
+			while (iss >> token)
+			{
+				if (token == "depth")
+					iss >> depth;
+				else if (token == "hash")
+					iss >> hash_size;
+			}
+
+			runBench(depth, hash_size);
+		}
+		else if (token == "tune")
+		{
+			std::string filename;
+			Tuner::Settings settings;
+			iss >> filename;
+
+			while (iss >> token)
+			{
+				if (token == "epochs")
+					iss >> settings.epochs;
+				else if (token == "batch")
+					iss >> settings.batch_size;
+				else if (token == "rate")
+					iss >> settings.learning_rate;
+				else if (token == "threads")
+					iss >> settings.threads;
+				else if (token == "out")
+					iss >> settings.out_file;
+			}
+
+			Tuner::tune(filename, settings, UciIo::send);
+		}
+		else if (token == "match")
+		{
+			std::string filename;
+			Match::Settings settings;
+			bool params_loaded = true;
+			iss >> filename;
+
+			while (iss >> token)
+			{
+				if (token == "games")
+					iss >> settings.games;
+				else if (token == "threads")
+					iss >> settings.threads;
+				else if (token == "depth")
+					iss >> settings.depth;
+				else if (token == "nodes")
+					iss >> settings.nodes;
+				else if (token == "movetime")
+					iss >> settings.movetime;
+				else if (token == "tc")
+				{
+					char plus;
+					iss >> settings.base_time >> plus >> settings.increment;
+				}
+				else if (token == "hash")
+					iss >> settings.hash_size;
+				else if (token == "evalfile")
+				{
+					std::string evalfile;
+					iss >> evalfile;
+					try
+					{
+						Evaluation::loadParams(evalfile, settings.params);
+					}
+					catch (Evaluation::ParamsParseError e)
+					{
+						UciIo::send("info string Error loading evaluation parameters: " + evalfile);
+						params_loaded = false;
+					}
+				}
+				else if (token == "elo0")
+					iss >> settings.elo0;
+				else if (token == "elo1")
+					iss >> settings.elo1;
+				else if (token == "alpha")
+					iss >> settings.alpha;
+				else if (token == "beta")
+					iss >> settings.beta;
+			}
+
+			if (params_loaded)
+				Match::run(filename, settings, UciIo::send);
+		}
 		else
 		{
-			std::cout << "Unrecognized command: " << line << std::endl;
+			UciIo::send("Unrecognized command: " + line);
 		}
 	}
+
+	UciIo::stop();
 }
 
 void setoptionReceived(Search::Search &search, std::string name, std::string value)
@@ -236,6 +440,72 @@ void setoptionReceived(Search::Search &search, std::string name, std::string val
 		ss >> size;
 		search.setHashSize(size);
 	}
+	else if (name == "MultiPV")
+	{
+		std::stringstream ss(value);
+		int multipv;
+		ss >> multipv;
+		search.setMultiPv(std::max(1, multipv));
+	}
+	else if (name == "EvalFile")
+	{
+		if (value.empty() || value == "<empty>")
+			Evaluation::resetParams();
+		else
+		{
+			try
+			{
+				Evaluation::loadParams(value);
+			}
+			catch (Evaluation::ParamsParseError e)
+			{
+				UciIo::send("info string Error loading evaluation parameters: " + value);
+			}
+		}
+		search.setEvalParams(Evaluation::activeParams());
+	}
+	else if (name == "OwnBook")
+	{
+		search.setOwnBook(value == "true");
+	}
+	else if (name == "BookFile")
+	{
+		if (!search.loadBook(value) && !value.empty() && value != "<empty>")
+			UciIo::send("info string Error loading book: " + value);
+	}
+	else if (name == "BookBestMove")
+	{
+		search.setBookBestMove(value == "true");
+	}
+	else if (name == "SyzygyPath")
+	{
+		int count = Tablebase::init(value == "<empty>" ? "" : value);
+		if (count)
+			UciIo::send("info string Found " + std::to_string(count) + " tablebases");
+		else if (!value.empty() && value != "<empty>")
+			UciIo::send("info string No tablebases found: " + value);
+	}
+	else if (name == "SyzygyProbeLimit")
+	{
+		std::stringstream ss(value);
+		int limit;
+		ss >> limit;
+		search.setSyzygyProbeLimit(limit);
+	}
+	else if (name == "InfoInterval")
+	{
+		std::stringstream ss(value);
+		int interval;
+		ss >> interval;
+		search.setInfoInterval(std::chrono::milliseconds(std::max(0, interval)));
+	}
+	else if (name == "CurrmoveDelay")
+	{
+		std::stringstream ss(value);
+		int delay;
+		ss >> delay;
+		search.setCurrmoveDelay(std::chrono::milliseconds(std::max(0, delay)));
+	}
 }
 
 void perftReceived(Board board, int depth, std::vector<Move> moves, bool per_move, bool full)
@@ -245,30 +515,29 @@ void perftReceived(Board board, int depth, std::vector<Move> moves, bool per_mov
 		board.makeMove(move);
 	}
 
-	std::cout << std::endl << "perft results" << std::endl;
-	std::cout << "fen\t\t\t" << board.fen() << std::endl;
-	std::cout << "depth\t\t\t" << depth << std::endl;
-	std::cout << std::endl;
+	UciIo::send("");
+	UciIo::send("perft results");
+	UciIo::send("fen\t\t\t" + board.fen());
+	UciIo::send("depth\t\t\t" + std::to_string(depth));
+	UciIo::send("");
 
 	if (per_move)
 	{
 		auto res = Perft::perftDivided(board, depth);
 		for (auto p : res)
 		{
-			std::cout << p.first.toAlgebraic() << ":\t";
-
 			if (full)
 			{
-				std::cout << std::endl;
+				UciIo::send(p.first.toAlgebraic() + ":");
 				printPerftRes(p.second);
-				std::cout << std::endl;
+				UciIo::send("");
 			}
 			else
-				std::cout << p.second.nodes << std::endl;
+				UciIo::send(p.first.toAlgebraic() + ":\t" + std::to_string(p.second.nodes));
 		}
 
 		if (full)
-			std::cout << std::endl;
+			UciIo::send("");
 	}
 	else
 	{
@@ -279,12 +548,12 @@ void perftReceived(Board board, int depth, std::vector<Move> moves, bool per_mov
 
 void printPerftRes(const Perft::PerftResult& res)
 {
-	std::cout << "nodes\t\t\t" << res.nodes << std::endl;
-	std::cout << "captures\t\t" << res.captures << std::endl;
-	std::cout << "en passants\t\t" << res.en_passants << std::endl;
-	std::cout << "kingside castles\t" << res.king_castles << std::endl;
-	std::cout << "queenside castles\t" << res.queen_castles << std::endl;
-	std::cout << "promotions\t\t" << res.promotions << std::endl;
+	UciIo::send("nodes\t\t\t" + std::to_string(res.nodes));
+	UciIo::send("captures\t\t" + std::to_string(res.captures));
+	UciIo::send("en passants\t\t" + std::to_string(res.en_passants));
+	UciIo::send("kingside castles\t" + std::to_string(res.king_castles));
+	UciIo::send("queenside castles\t" + std::to_string(res.queen_castles));
+	UciIo::send("promotions\t\t" + std::to_string(res.promotions));
 }
 
 void runTest(const std::string &in_file, int depth, const std::string &out_file)
@@ -323,10 +592,6 @@ void runTest(const std::string &in_file, int depth, const std::string &out_file)
 
 	for (int i = 0; i < epdData.size(); ++i)
 	{
-		std::stringstream status_message;
-		status_message << "Running tests... (" << i + 1 << "/" << epdData.size() << ")";
-		std::cout << status_message.str();
-
 		std::stringstream message;
 		Move bestMove;
 
@@ -344,7 +609,9 @@ void runTest(const std::string &in_file, int depth, const std::string &out_file)
 		}
 
 		messages.push_back(message.str());
-		std::cout << std::string(status_message.str().size(), '\b');
+
+		// The output goes out by lines, so the progress is reported on a line per test
+		UciIo::send("info string test " + std::to_string(i + 1) + "/" + std::to_string(epdData.size()) + " " + message.str());
 	}
 
 	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
@@ -380,5 +647,39 @@ void runTest(const std::string &in_file, int depth, const std::string &out_file)
 	}
 
 	out.close();
-	std::cout << std::endl << "Finished" << std::endl;
-}
\ No newline at end of file
+	UciIo::send("Finished");
+}
+void runBench(int depth, size_t hash_size)
+{
+	const static std::string fens[] = {
+		start_fen,
+		"r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+		"r2q1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2Q1RK1 w - - 0 10",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		"3r1k2/4npp1/1ppr3p/p6P/P2PPPP1/1NR5/5K2/2R5 w - - 0 1",
+		"8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+	};
+
+	Search::Search search;
+	search.setMaxDepth(depth);
+	search.setHashSize(hash_size);
+
+	u64 nodes = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (const std::string &fen : fens)
+	{
+		search.search(Board::fromFen(fen), nullptr, true);
+		nodes += search.getStats().alpha_beta_nodes + search.getStats().quiescence_nodes;
+	}
+
+	u64 duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+	UciIo::send("nodes " + std::to_string(nodes));
+	UciIo::send("time " + std::to_string(duration) + " ms");
+	UciIo::send("nps " + std::to_string(nodes * 1000 / std::max(duration, (u64)1)));
+}
@@ -1,4 +1,7 @@
 #include "search.h"
+#include "uci_io.h"
+
+#include <sstream>
 
 class SearchEventHandler
 {
@@ -9,8 +12,7 @@ public:
 		search.onBestMove = &onBestMove;
 		search.onPrincipalVariation = onPrincipalVariation;
 		search.onCurrentMove = onCurrentMove;
-		search.onNodeInfo = onNodeInfo;
-		search.onHashfull = onHashfull;
+		search.onSearchInfo = onSearchInfo;
 
 		if (debug)
 			search.onStats = onStats;
@@ -19,14 +21,16 @@ public:
 private:
 	static void onBestMove(Move move, Move ponder_move)
 	{
-		std::cout << "bestmove " << move.toAlgebraic();
+		std::ostringstream out;
+		out << "bestmove " << move.toAlgebraic();
 		if (ponder_move != Move())
-			std::cout << " ponder " << ponder_move.toAlgebraic();
-		std::cout << std::endl;
+			out << " ponder " << ponder_move.toAlgebraic();
+		UciIo::send(out.str());
 	}
 
-	static void onPrincipalVariation(const std::array<Move, MAX_DEPTH>& pv, int depth, int score, bool mate)
+	static void onPrincipalVariation(const std::array<Move, MAX_DEPTH>& pv, int depth, int score, ScoreType score_type, int multipv)
 	{
+		std::ostringstream out;
 		int moves_nb = depth;
 
 		if (SCORE_MIN_MATE <= abs(score) && abs(score) <= SCORE_MAX_MATE)
@@ -35,38 +39,63 @@ private:
 			int mate_in = (int)round(moves_nb / 2.0);
 			if (score < 0)
 				mate_in *= -1;
-			std::cout << "info depth " << depth << " score mate " << mate_in << " pv";
+			out << "info depth " << depth << " multipv " << multipv << " score mate " << mate_in;
 		}
 		else
-			std::cout << "info depth " << depth << " score cp " << score << " pv";
+			out << "info depth " << depth << " multipv " << multipv << " score cp " << score;
+
+		if (score_type == LOWER_BOUND)
+			out << " lowerbound";
+		else if (score_type == UPPER_BOUND)
+			out << " upperbound";
 
-		for (int i = 0; i < moves_nb; ++i)
+		out << " pv";
+		for (int i = 0; i < moves_nb && pv[i].isValid(); ++i)
 		{
-			std::cout << " " << pv[i].toAlgebraic();
+			out << " " << pv[i].toAlgebraic();
 		}
-		std::cout << std::endl;
+		UciIo::send(out.str());
 	}
 
-	static void onCurrentMove(Move move, int pos)
+	static void onCurrentMove(Move move, int pos, u64 nodes)
 	{
-		std::cout << "info currmove " << move.toAlgebraic() << " currmovenumber " << pos << std::endl;
-	}
+		std::ostringstream out;
+		out << "info currmove " << move.toAlgebraic() << " currmovenumber " << pos;
 
-	static void onNodeInfo(u64 node_count, u64 nodes_per_sec)
-	{
-		std::cout << "info nodes " << node_count
-			<< " nps " << nodes_per_sec << std::endl;
+		// The nodes of the move in the previous iteration, as a string since the nodes field of the
+		// protocol is the total of the search
+		out << " string nodes " << nodes;
+		UciIo::send(out.str());
 	}
 
-	static void onHashfull(int permill)
+	static void onSearchInfo(u64 node_count, u64 nodes_per_sec, int hashfull, std::chrono::milliseconds time)
 	{
-		std::cout << "info hashfull " << permill << std::endl;
+		std::ostringstream out;
+		out << "info nodes " << node_count
+			<< " nps " << nodes_per_sec
+			<< " hashfull " << hashfull
+			<< " time " << time.count();
+		UciIo::send(out.str());
 	}
 
 	static void onStats(const Search::Search::Stats &stats)
 	{
-		std::cout << std::endl
+		std::ostringstream out;
+		out << std::endl
 			<< "info string " << "\tpv_search_researches:\t" << stats.pv_search_research_count << std::endl
+			<< "info string " << "\tlmr reductions:\t\t" << stats.lmr_reductions << std::endl
+			<< "info string " << "\tlmr researches:\t\t" << stats.lmr_research_count << std::endl
+			<< "info string " << "\taspiration researches:\t" << stats.aspiration_research_count << std::endl
+			<< "info string " << "\tsingular extensions:\t" << stats.singular_extensions << std::endl
+			<< "info string " << "\tmulti-cut prunes:\t" << stats.multi_cut_prunes << std::endl
+			<< "info string " << "\tprobcut prunes:\t\t" << stats.probcut_prunes << std::endl
+			<< "info string " << "\tiid reductions:\t\t" << stats.iid_reductions << std::endl
+			<< "info string " << "\tlate move prunes:\t" << stats.late_move_prunes << std::endl
+			<< "info string " << "\tfutility prunes:\t" << stats.futility_prunes << std::endl
+			<< "info string " << "\tsee prunes:\t\t" << stats.see_prunes << std::endl
+			<< "info string " << "\tdraws detected:\t\t" << stats.draws_detected << std::endl
+			<< "info string " << "\ttablebase hits:\t\t" << stats.tablebase_hits << std::endl
+			<< "info string " << "\tmax time check gap:\t" << stats.max_time_check_gap << " us" << std::endl
 			<< "info string " << "\tkiller move cutoffs:\t" << stats.killer_move_cutoffs << std::endl
 			<< "info string " << "\thash move cutoffs:\t" << stats.hash_move_cutoffs << std::endl
 			<< "info string " << "\thash score returned:\t" << stats.hash_score_returned << std::endl
@@ -74,6 +103,7 @@ private:
 			<< "info string " << "\talpha-beta nodes:\t" << stats.alpha_beta_nodes << std::endl
 			<< "info string " << "\tquiescence nodes:\t" << stats.quiescence_nodes << std::endl
 			<< "info string " << "\talpha-beta cutoffs:\t" << stats.alpha_beta_cutoffs << std::endl
-			<< "info string " << "\tquiescence cutoffs:\t" << stats.quiescence_cutoffs << std::endl;
+			<< "info string " << "\tquiescence cutoffs:\t" << stats.quiescence_cutoffs;
+		UciIo::send(out.str());
 	}
 };
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "uci_io.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace UciIo
+{
+	namespace
+	{
+		// Single producer, single consumer ring buffer of the input lines. The reader thread is the
+		// only one moving the tail and the command loop the only one moving the head.
+		const size_t QueueSize = 256;
+		std::array<std::string, QueueSize> Commands;
+		std::atomic<size_t> Head(0);
+		std::atomic<size_t> Tail(0);
+		std::atomic<bool> InputClosed(false);
+
+		// Commands queued or being processed
+		std::atomic<int> Pending(0);
+		bool HasCurrent = false;
+
+		// Only used to sleep while the queue is empty, the queue itself is not guarded
+		std::mutex WaitMutex;
+		std::condition_variable WaitCondition;
+
+		ImmediateHandler Immediate;
+		std::ofstream Log;
+
+		std::mutex OutputMutex;
+		std::condition_variable OutputCondition;
+		std::string Output;
+		bool WriterStopped = false;
+		std::thread Writer;
+
+		void wakeCommandLoop()
+		{
+			std::lock_guard<std::mutex> lock(WaitMutex);
+			WaitCondition.notify_one();
+		}
+
+		void readInput()
+		{
+			std::string line;
+			while (std::getline(std::cin, line))
+			{
+				if (Pending.load() == 0 && Immediate && Immediate(line))
+				{
+					Log << line << std::endl;
+					continue;
+				}
+
+				size_t tail = Tail.load(std::memory_order_relaxed);
+				while (tail - Head.load(std::memory_order_acquire) == QueueSize)
+					std::this_thread::yield();
+
+				Commands[tail % QueueSize] = line;
+				Pending.fetch_add(1);
+				Tail.store(tail + 1, std::memory_order_release);
+				wakeCommandLoop();
+
+				Log << line << std::endl;
+			}
+
+			InputClosed.store(true);
+			wakeCommandLoop();
+		}
+
+		void writeOutput()
+		{
+			std::string buffer;
+			std::unique_lock<std::mutex> lock(OutputMutex);
+			while (true)
+			{
+				OutputCondition.wait(lock, [] { return WriterStopped || !Output.empty(); });
+				if (Output.empty())
+					break;
+
+				buffer.swap(Output);
+				lock.unlock();
+
+				std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+				std::fflush(stdout);
+				buffer.clear();
+
+				lock.lock();
+			}
+		}
+	}
+
+	void start(ImmediateHandler immediate_handler, const std::string &log_file)
+	{
+		Immediate = immediate_handler;
+		Log.open(log_file);
+
+		Writer = std::thread(writeOutput);
+
+		// Blocked in getline until the input is closed, so it can't be joined
+		std::thread(readInput).detach();
+	}
+
+	bool nextCommand(std::string &line)
+	{
+		if (HasCurrent)
+		{
+			Pending.fetch_sub(1);
+			HasCurrent = false;
+		}
+
+		size_t head = Head.load(std::memory_order_relaxed);
+		if (Tail.load(std::memory_order_acquire) == head)
+		{
+			std::unique_lock<std::mutex> lock(WaitMutex);
+			WaitCondition.wait(lock, [head] { return Tail.load(std::memory_order_acquire) != head || InputClosed.load(); });
+
+			if (Tail.load(std::memory_order_acquire) == head)
+				return false;
+		}
+
+		line.swap(Commands[head % QueueSize]);
+		Head.store(head + 1, std::memory_order_release);
+		HasCurrent = true;
+		return true;
+	}
+
+	void send(const std::string &line)
+	{
+		{
+			std::lock_guard<std::mutex> lock(OutputMutex);
+			Output += line;
+			Output += '\n';
+		}
+		OutputCondition.notify_one();
+	}
+
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(OutputMutex);
+			WriterStopped = true;
+		}
+		OutputCondition.notify_one();
+
+		if (Writer.joinable())
+			Writer.join();
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+// Console I/O of the UCI protocol. Input lines are read into a queue by a reader thread and output
+// lines are buffered and written by a writer thread, so neither the command loop nor the search
+// ever waits on the console.
+namespace UciIo
+{
+	// Called on the reader thread for each line, returns true if the command was handled and must
+	// not be queued. It is only called when all the earlier commands have been processed, so that
+	// a stop can't overtake the go it belongs to.
+	typedef std::function<bool(const std::string &line)> ImmediateHandler;
+
+	// Starts the threads, the input lines are logged to the given file
+	void start(ImmediateHandler immediate_handler, const std::string &log_file);
+
+	// Marks the previous command processed and waits for the next one, returns false at the end
+	// of the input
+	bool nextCommand(std::string &line);
+
+	// Queues a line for output
+	void send(const std::string &line);
+
+	// Writes the queued output and stops the writer thread
+	void stop();
+}
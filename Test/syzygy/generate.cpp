@@ -0,0 +1,1296 @@
+// Writes the Syzygy tables the unit tests probe: KQvK, KRvK, KBvK, KNvK, KPvK, KBNvK and KPvKP.
+//
+// Every table is solved by retrograde analysis, together with the tables reached by captures and
+// promotions, and written in the Syzygy format read by Engine/tablebase.cpp: canonical Huffman codes
+// over recursively paired symbols, split in blocks with a sparse index. The 16 byte trailer of a real
+// file is a checksum, which the probing code doesn't read, so it is left zero here.
+//
+// Build and run it in this directory:
+//   cl /O2 /EHsc generate.cpp && generate.exe
+//   g++ -O2 -std=c++17 generate.cpp -o generate && ./generate
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+typedef uint64_t u64;
+
+namespace
+{
+	// Piece types are coded as in the files: 1 (pawn) to 6 (king), plus 8 for black
+	enum PieceType { PAWN = 1, KNIGHT, BISHOP, ROOK, QUEEN, KING };
+	enum Color { WHITE, BLACK };
+
+	const char PieceChars[] = " PNBRQK";
+	const int8_t Illegal = INT8_MIN;
+
+	void check(bool condition, const std::string &message)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "%s\n", message.c_str());
+			exit(1);
+		}
+	}
+
+	int fileOf(int sq) { return sq & 7; }
+	int rankOf(int sq) { return sq >> 3; }
+
+	u64 KingAttacks[64], KnightAttacks[64], PawnAttacks[2][64];
+	u64 Between[64][64];
+
+	// 1 if the squares share a rank or a file, 2 if they share a diagonal
+	int Line[64][64];
+
+	u64 Binomial[8][65];
+
+	void init()
+	{
+		for (int s = 0; s < 64; ++s)
+		{
+			for (int t = 0; t < 64; ++t)
+			{
+				int df = fileOf(t) - fileOf(s), dr = rankOf(t) - rankOf(s);
+				if (std::max(abs(df), abs(dr)) == 1)
+					KingAttacks[s] |= 1ULL << t;
+				if (abs(df) * abs(dr) == 2)
+					KnightAttacks[s] |= 1ULL << t;
+				if (abs(dr) == 1 && abs(df) == 1)
+					PawnAttacks[dr > 0 ? WHITE : BLACK][s] |= 1ULL << t;
+
+				if (s != t && (df == 0 || dr == 0 || abs(df) == abs(dr)))
+				{
+					Line[s][t] = df == 0 || dr == 0 ? 1 : 2;
+					int step = ((dr > 0) - (dr < 0)) * 8 + (df > 0) - (df < 0);
+					for (int x = s + step; x != t; x += step)
+						Between[s][t] |= 1ULL << x;
+				}
+			}
+		}
+
+		for (int n = 0; n <= 64; ++n)
+		{
+			for (int k = 0; k < 8; ++k)
+				Binomial[k][n] = k == 0 ? 1 : n == 0 ? 0 : Binomial[k - 1][n - 1] + Binomial[k][n - 1];
+		}
+	}
+
+	u64 slide(int sq, u64 occupied, bool diagonal)
+	{
+		static const int Directions[2][4][2] = {
+			{ { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } },
+			{ { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } }
+		};
+
+		u64 attacks = 0;
+		for (const int *d : Directions[diagonal])
+		{
+			for (int f = fileOf(sq) + d[0], r = rankOf(sq) + d[1]; f >= 0 && f < 8 && r >= 0 && r < 8; f += d[0], r += d[1])
+			{
+				attacks |= 1ULL << (r * 8 + f);
+				if (occupied >> (r * 8 + f) & 1)
+					break;
+			}
+		}
+		return attacks;
+	}
+
+	// The squares a piece other than a pawn moves to
+	u64 attacks(int type, int sq, u64 occupied)
+	{
+		switch (type)
+		{
+		case KNIGHT: return KnightAttacks[sq];
+		case BISHOP: return slide(sq, occupied, true);
+		case ROOK: return slide(sq, occupied, false);
+		case QUEEN: return slide(sq, occupied, true) | slide(sq, occupied, false);
+		default: return KingAttacks[sq];
+		}
+	}
+
+	struct Piece
+	{
+		int color;
+		int type;
+	};
+
+	struct Position
+	{
+		int count;
+		int color[4], type[4], sq[4];
+		int stm;
+
+		// The square passed by a double pawn push, -1 if there is none
+		int ep;
+
+		u64 occupied() const
+		{
+			u64 occupied = 0;
+			for (int i = 0; i < count; ++i)
+				occupied |= 1ULL << sq[i];
+			return occupied;
+		}
+
+		int pieceAt(int s) const
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				if (sq[i] == s)
+					return i;
+			}
+			return -1;
+		}
+
+		void remove(int i)
+		{
+			for (int j = i; j < count - 1; ++j)
+			{
+				color[j] = color[j + 1];
+				type[j] = type[j + 1];
+				sq[j] = sq[j + 1];
+			}
+			--count;
+		}
+	};
+
+	bool attacked(const Position &pos, int sq, int by)
+	{
+		u64 occupied = pos.occupied();
+		for (int i = 0; i < pos.count; ++i)
+		{
+			if (pos.color[i] != by)
+				continue;
+
+			int s = pos.sq[i];
+			switch (pos.type[i])
+			{
+			case PAWN:
+				if (PawnAttacks[by][s] >> sq & 1)
+					return true;
+				break;
+			case KNIGHT:
+				if (KnightAttacks[s] >> sq & 1)
+					return true;
+				break;
+			case KING:
+				if (KingAttacks[s] >> sq & 1)
+					return true;
+				break;
+			default:
+				int line = Line[s][sq];
+				if (line && !(Between[s][sq] & occupied)
+					&& (pos.type[i] == QUEEN || (pos.type[i] == ROOK) == (line == 1)))
+					return true;
+			}
+		}
+		return false;
+	}
+
+	bool inCheck(const Position &pos, int color)
+	{
+		for (int i = 0; i < pos.count; ++i)
+		{
+			if (pos.color[i] == color && pos.type[i] == KING)
+				return attacked(pos, pos.sq[i], !color);
+		}
+		return false;
+	}
+
+	// Calls f(child, zeroing) for every legal move. The zeroing moves are the captures and the pawn
+	// moves, they leave the table or the pawn configuration.
+	void forEachMove(const Position &pos, const std::function<void(const Position&, bool)> &f)
+	{
+		u64 occupied = pos.occupied();
+
+		for (int i = 0; i < pos.count; ++i)
+		{
+			if (pos.color[i] != pos.stm)
+				continue;
+
+			auto play = [&](int to, int promotion, bool double_push)
+			{
+				Position child = pos;
+				child.sq[i] = to;
+				child.stm = !pos.stm;
+				child.ep = double_push ? (pos.sq[i] + to) / 2 : -1;
+				if (promotion)
+					child.type[i] = promotion;
+
+				int captured = pos.pieceAt(to);
+				if (captured >= 0)
+					child.remove(captured);
+
+				if (!inCheck(child, pos.stm))
+					f(child, captured >= 0 || pos.type[i] == PAWN);
+			};
+
+			int from = pos.sq[i];
+			if (pos.type[i] == PAWN)
+			{
+				int forward = pos.stm == WHITE ? 8 : -8;
+				bool promotes = rankOf(from + forward) == (pos.stm == WHITE ? 7 : 0);
+
+				std::vector<int> targets;
+				if (!(occupied >> (from + forward) & 1))
+					targets.push_back(from + forward);
+				for (int i2 = 0; i2 < pos.count; ++i2)
+				{
+					if (pos.color[i2] != pos.stm && PawnAttacks[pos.stm][from] >> pos.sq[i2] & 1)
+						targets.push_back(pos.sq[i2]);
+				}
+
+				for (int to : targets)
+				{
+					if (promotes)
+					{
+						for (int promotion = QUEEN; promotion >= KNIGHT; --promotion)
+							play(to, promotion, false);
+					}
+					else
+						play(to, 0, false);
+				}
+
+				bool start = rankOf(from) == (pos.stm == WHITE ? 1 : 6);
+				if (start && !(occupied >> (from + forward) & 1) && !(occupied >> (from + 2 * forward) & 1))
+					play(from + 2 * forward, 0, true);
+			}
+			else
+			{
+				u64 own = 0;
+				for (int j = 0; j < pos.count; ++j)
+				{
+					if (pos.color[j] == pos.stm)
+						own |= 1ULL << pos.sq[j];
+				}
+
+				u64 targets = attacks(pos.type[i], from, occupied) & ~own;
+				for (int to = 0; to < 64; ++to)
+				{
+					if (targets >> to & 1)
+						play(to, 0, false);
+				}
+			}
+		}
+	}
+
+	// A table covers every placement of its pieces with either side to move. The values are from the
+	// side to move: d > 0 wins and d < 0 loses, the clock is zeroed (or the game mated) in |d| plies
+	// of the best play, 0 is a draw.
+	struct Table
+	{
+		// By color, then from the king down
+		std::vector<Piece> pieces;
+		std::vector<int8_t> value;
+
+		u64 index(const Position &pos) const
+		{
+			u64 idx = pos.stm;
+			for (int i = 0; i < pos.count; ++i)
+				idx |= (u64)pos.sq[i] << (1 + 6 * i);
+			return idx;
+		}
+
+		Position position(u64 idx) const
+		{
+			Position pos;
+			pos.count = (int)pieces.size();
+			pos.stm = idx & 1;
+			pos.ep = -1;
+			for (int i = 0; i < pos.count; ++i)
+			{
+				pos.color[i] = pieces[i].color;
+				pos.type[i] = pieces[i].type;
+				pos.sq[i] = (idx >> (1 + 6 * i)) & 63;
+			}
+			return pos;
+		}
+	};
+
+	std::string name(const std::vector<Piece> &pieces)
+	{
+		std::string name[2];
+		for (const Piece &piece : pieces)
+			name[piece.color] += PieceChars[piece.type];
+		return name[WHITE] + "v" + name[BLACK];
+	}
+
+	std::map<std::string, std::unique_ptr<Table>> Tables;
+
+	Table &solve(const std::vector<Piece> &pieces);
+
+	// The tables are kept with the stronger side as white, as the files are named
+	bool blackStronger(const Position &pos)
+	{
+		std::vector<int> types[2];
+		for (int i = 0; i < pos.count; ++i)
+			types[pos.color[i]].push_back(pos.type[i]);
+		for (std::vector<int> &t : types)
+			std::sort(t.rbegin(), t.rend());
+		return types[BLACK] > types[WHITE];
+	}
+
+	// The result of the position for the side to move, without en passant captures
+	int probe(Position pos)
+	{
+		if (pos.count == 2)
+			return 0;
+
+		if (blackStronger(pos))
+		{
+			for (int i = 0; i < pos.count; ++i)
+			{
+				pos.color[i] = !pos.color[i];
+				pos.sq[i] ^= 56;
+			}
+			pos.stm = !pos.stm;
+		}
+
+		// Sort the pieces as the table does
+		for (int i = 0; i < pos.count; ++i)
+		{
+			for (int j = i + 1; j < pos.count; ++j)
+			{
+				if (std::make_pair(pos.color[j], -pos.type[j]) < std::make_pair(pos.color[i], -pos.type[i]))
+				{
+					std::swap(pos.color[i], pos.color[j]);
+					std::swap(pos.type[i], pos.type[j]);
+					std::swap(pos.sq[i], pos.sq[j]);
+				}
+			}
+		}
+
+		std::vector<Piece> pieces;
+		for (int i = 0; i < pos.count; ++i)
+			pieces.push_back({ pos.color[i], pos.type[i] });
+
+		const Table &table = solve(pieces);
+		int value = table.value[table.index(pos)];
+		check(value != Illegal, "Probed an illegal position of " + name(pieces));
+		return (value > 0) - (value < 0);
+	}
+
+	// The result for the side to move after a zeroing move, which may allow an en passant capture
+	int probeZeroed(const Position &pos)
+	{
+		int value = probe(pos);
+		if (pos.ep < 0)
+			return value;
+
+		int pushed = pos.pieceAt(pos.ep + (pos.stm == WHITE ? -8 : 8));
+		for (int i = 0; i < pos.count; ++i)
+		{
+			if (pos.color[i] != pos.stm || pos.type[i] != PAWN || !(PawnAttacks[pos.stm][pos.sq[i]] >> pos.ep & 1))
+				continue;
+
+			Position child = pos;
+			child.sq[i] = pos.ep;
+			child.stm = !pos.stm;
+			child.ep = -1;
+			child.remove(pushed);
+
+			if (!inCheck(child, pos.stm))
+				value = std::max(value, -probe(child));
+		}
+		return value;
+	}
+
+	enum Flag
+	{
+		MATED = 1, DRAWING_EXIT = 2
+	};
+
+	// Solves the positions with the pawns on the given squares. Only the other pieces move inside a
+	// layer, the pawn moves lead to layers that are already solved.
+	void solveLayer(Table &table, const std::vector<int> &pawns, const std::vector<int> &pawn_squares,
+		std::vector<uint8_t> &moves_left, std::vector<uint8_t> &flags)
+	{
+		std::vector<int> others;
+		for (int i = 0; i < (int)table.pieces.size(); ++i)
+		{
+			if (table.pieces[i].type != PAWN)
+				others.push_back(i);
+		}
+
+		Position pos = table.position(0);
+		for (size_t k = 0; k < pawns.size(); ++k)
+			pos.sq[pawns[k]] = pawn_squares[k];
+
+		std::vector<u64> mated, current;
+
+		// Every placement of the other pieces on the free squares
+		std::function<void(size_t, u64)> place = [&](size_t k, u64 occupied)
+		{
+			if (k == others.size())
+			{
+				for (int stm = WHITE; stm <= BLACK; ++stm)
+				{
+					pos.stm = stm;
+					u64 idx = table.index(pos);
+
+					if (inCheck(pos, !stm))
+						continue;
+
+					int legal = 0, best_exit = -2;
+					forEachMove(pos, [&](const Position &child, bool zeroing)
+					{
+						++legal;
+						if (zeroing)
+							best_exit = std::max(best_exit, -probeZeroed(child));
+						else
+							++moves_left[idx];
+					});
+
+					table.value[idx] = 0;
+					if (!legal)
+					{
+						if (inCheck(pos, stm))
+						{
+							table.value[idx] = -1;
+							flags[idx] |= MATED;
+							mated.push_back(idx);
+						}
+					}
+					else if (best_exit == 1)
+					{
+						table.value[idx] = 1;
+						current.push_back(idx);
+					}
+					else if (best_exit == 0)
+						flags[idx] |= DRAWING_EXIT;
+					else if (!moves_left[idx])
+					{
+						table.value[idx] = -1;
+						current.push_back(idx);
+					}
+				}
+				return;
+			}
+
+			for (int sq = 0; sq < 64; ++sq)
+			{
+				if (occupied >> sq & 1)
+					continue;
+				pos.sq[others[k]] = sq;
+				place(k + 1, occupied | 1ULL << sq);
+			}
+		};
+
+		u64 occupied = 0;
+		for (int sq : pawn_squares)
+			occupied |= 1ULL << sq;
+		place(0, occupied);
+
+		// Calls f for the unsolved positions the side that just moved came from
+		auto forEachParent = [&](u64 idx, const std::function<void(u64)> &f)
+		{
+			Position child = table.position(idx);
+			u64 occupied = child.occupied();
+
+			for (int i = 0; i < child.count; ++i)
+			{
+				if (child.color[i] == child.stm || child.type[i] == PAWN)
+					continue;
+
+				Position parent = child;
+				parent.stm = !child.stm;
+				u64 from = attacks(child.type[i], child.sq[i], occupied) & ~occupied;
+
+				for (int sq = 0; sq < 64; ++sq)
+				{
+					if (!(from >> sq & 1))
+						continue;
+					parent.sq[i] = sq;
+					u64 parent_idx = table.index(parent);
+					if (table.value[parent_idx] == 0)
+						f(parent_idx);
+				}
+			}
+		};
+
+		// Mating is the fastest win, even if the mated position also counts one ply
+		for (u64 idx : mated)
+		{
+			forEachParent(idx, [&](u64 parent)
+			{
+				table.value[parent] = 1;
+				current.push_back(parent);
+			});
+		}
+
+		// The positions are solved in the order of their distance
+		for (int d = 1; !current.empty(); ++d)
+		{
+			check(d < 127, "Distance out of range in " + name(table.pieces));
+
+			std::vector<u64> next;
+			for (u64 idx : current)
+			{
+				if (table.value[idx] > 0)
+				{
+					forEachParent(idx, [&](u64 parent)
+					{
+						if (--moves_left[parent] == 0 && !(flags[parent] & DRAWING_EXIT))
+						{
+							table.value[parent] = (int8_t)-(d + 1);
+							next.push_back(parent);
+						}
+					});
+				}
+				else
+				{
+					forEachParent(idx, [&](u64 parent)
+					{
+						table.value[parent] = (int8_t)(d + 1);
+						next.push_back(parent);
+					});
+				}
+			}
+			current.swap(next);
+		}
+	}
+
+	Table &solve(const std::vector<Piece> &pieces)
+	{
+		std::unique_ptr<Table> &entry = Tables[name(pieces)];
+		if (entry)
+			return *entry;
+
+		entry.reset(new Table());
+		Table &table = *entry;
+		table.pieces = pieces;
+		table.value.assign((size_t)2 << (6 * pieces.size()), Illegal);
+
+		std::vector<uint8_t> moves_left(table.value.size()), flags(table.value.size());
+
+		std::vector<int> pawns;
+		for (int i = 0; i < (int)pieces.size(); ++i)
+		{
+			if (pieces[i].type == PAWN)
+				pawns.push_back(i);
+		}
+
+		// The pawn configurations, the most advanced first since the pawn moves lead to them
+		std::vector<std::pair<int, std::vector<int>>> layers;
+		std::vector<int> squares;
+		std::function<void()> enumerate = [&]()
+		{
+			if (squares.size() == pawns.size())
+			{
+				int advance = 0;
+				for (size_t k = 0; k < pawns.size(); ++k)
+					advance += pieces[pawns[k]].color == WHITE ? rankOf(squares[k]) : 7 - rankOf(squares[k]);
+				layers.push_back(std::make_pair(-advance, squares));
+				return;
+			}
+
+			for (int sq = 8; sq < 56; ++sq)
+			{
+				if (std::find(squares.begin(), squares.end(), sq) != squares.end())
+					continue;
+				squares.push_back(sq);
+				enumerate();
+				squares.pop_back();
+			}
+		};
+		enumerate();
+		std::stable_sort(layers.begin(), layers.end(),
+			[](const std::pair<int, std::vector<int>> &a, const std::pair<int, std::vector<int>> &b) { return a.first < b.first; });
+
+		for (const auto &layer : layers)
+			solveLayer(table, pawns, layer.second, moves_left, flags);
+
+		int wins = 0, draws = 0, losses = 0, longest = 0;
+		for (int8_t value : table.value)
+		{
+			if (value == Illegal)
+				continue;
+			value > 0 ? ++wins : value < 0 ? ++losses : ++draws;
+			longest = std::max(longest, abs(value));
+		}
+
+		// Without cursed wins or blessed losses the results don't depend on the fifty-move rule
+		check(longest <= 100, "Zeroing takes more than 100 plies in " + name(pieces));
+		printf("%-6s %9d wins %9d draws %9d losses, longest %d plies\n", name(pieces).c_str(), wins, draws, losses, longest);
+		return table;
+	}
+
+	void put16(std::vector<uint8_t> &out, unsigned value)
+	{
+		out.push_back(value & 0xFF);
+		out.push_back((value >> 8) & 0xFF);
+	}
+
+	void put32(std::vector<uint8_t> &out, unsigned value)
+	{
+		put16(out, value & 0xFFFF);
+		put16(out, value >> 16);
+	}
+
+	// The values of one side to move and one file of the leading pawn, in the layout read by
+	// setSizes, followed by the sparse index, the block lengths and the blocks
+	struct Compressed
+	{
+		std::vector<uint8_t> sizes;
+		std::vector<uint8_t> sparse_index;
+		std::vector<uint8_t> block_lengths;
+		std::vector<uint8_t> blocks;
+	};
+
+	const int BlockSizeLog = 10;
+	const int SpanLog = 10;
+
+	// The most values a symbol stands for, its length minus one is stored in a byte
+	const int MaxSymbolLength = 256;
+	const int MaxSymbols = 4095;
+
+	Compressed compress(const std::vector<int> &values, int flags)
+	{
+		Compressed c;
+
+		if (std::count(values.begin(), values.end(), values[0]) == (long long)values.size())
+		{
+			c.sizes.push_back((uint8_t)(flags | 128));
+			c.sizes.push_back((uint8_t)values[0]);
+			return c;
+		}
+
+		// Recursive pairing: the most frequent pair of adjacent symbols is replaced by a new symbol
+		struct Symbol
+		{
+			int left, right, length;
+		};
+		std::vector<Symbol> symbols;
+		std::vector<int> leaf(4096, -1);
+		std::vector<int> seq;
+
+		for (int value : values)
+		{
+			check(value >= 0 && value < 4096, "Value out of range");
+			if (leaf[value] < 0)
+			{
+				leaf[value] = (int)symbols.size();
+				symbols.push_back({ value, -1, 1 });
+			}
+			seq.push_back(leaf[value]);
+		}
+
+		std::vector<unsigned> counts((size_t)MaxSymbols * MaxSymbols);
+		std::vector<unsigned> touched;
+
+		while ((int)symbols.size() < MaxSymbols)
+		{
+			for (size_t i = 0; i + 1 < seq.size(); ++i)
+			{
+				size_t key = (size_t)seq[i] * MaxSymbols + seq[i + 1];
+				if (!counts[key]++)
+					touched.push_back((unsigned)key);
+
+				// A run of the same symbol holds half as many pairs
+				if (seq[i] == seq[i + 1] && i + 2 < seq.size() && seq[i + 2] == seq[i])
+					++i;
+			}
+
+			size_t best = 0;
+			unsigned best_count = 0;
+			for (unsigned key : touched)
+			{
+				int length = symbols[key / MaxSymbols].length + symbols[key % MaxSymbols].length;
+				if (counts[key] > best_count && length <= MaxSymbolLength)
+				{
+					best = key;
+					best_count = counts[key];
+				}
+				counts[key] = 0;
+			}
+			touched.clear();
+
+			if (best_count < 8)
+				break;
+
+			int left = (int)(best / MaxSymbols), right = (int)(best % MaxSymbols);
+			int paired = (int)symbols.size();
+			symbols.push_back({ left, right, symbols[left].length + symbols[right].length });
+
+			size_t out = 0;
+			for (size_t i = 0; i < seq.size(); ++i)
+			{
+				if (i + 1 < seq.size() && seq[i] == left && seq[i + 1] == right)
+				{
+					seq[out++] = paired;
+					++i;
+				}
+				else
+					seq[out++] = seq[i];
+			}
+			seq.resize(out);
+		}
+
+		// Huffman code lengths of the symbols left in the sequence
+		std::vector<u64> frequency(symbols.size());
+		for (int sym : seq)
+			frequency[sym]++;
+
+		std::vector<int> code_length(symbols.size());
+		{
+			typedef std::pair<u64, int> Node;
+			std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+			std::vector<int> parent;
+
+			for (int sym = 0; sym < (int)symbols.size(); ++sym)
+			{
+				if (frequency[sym])
+				{
+					queue.push(Node(frequency[sym], (int)parent.size()));
+					parent.push_back(-1);
+				}
+			}
+
+			int leaves = (int)parent.size();
+			while (queue.size() > 1)
+			{
+				Node a = queue.top();
+				queue.pop();
+				Node b = queue.top();
+				queue.pop();
+				parent[a.second] = parent[b.second] = (int)parent.size();
+				queue.push(Node(a.first + b.first, (int)parent.size()));
+				parent.push_back(-1);
+			}
+
+			int leaf_idx = 0;
+			for (int sym = 0; sym < (int)symbols.size(); ++sym)
+			{
+				if (!frequency[sym])
+					continue;
+				int length = 0;
+				for (int node = leaf_idx++; parent[node] >= 0; node = parent[node])
+					++length;
+				code_length[sym] = std::max(length, 1);
+			}
+			check(leaves == leaf_idx, "Huffman code");
+		}
+
+		int min_length = 64, max_length = 0;
+		for (int sym = 0; sym < (int)symbols.size(); ++sym)
+		{
+			if (frequency[sym])
+			{
+				min_length = std::min(min_length, code_length[sym]);
+				max_length = std::max(max_length, code_length[sym]);
+			}
+		}
+		check(max_length <= 32, "Huffman code too long");
+
+		// The coded symbols are numbered from the longest codes to the shortest, then come the
+		// symbols only used in pairs
+		std::vector<int> order(symbols.size());
+		for (int sym = 0; sym < (int)symbols.size(); ++sym)
+			order[sym] = sym;
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+		{
+			return (frequency[a] ? -code_length[a] : 1) < (frequency[b] ? -code_length[b] : 1);
+		});
+
+		std::vector<int> id(symbols.size());
+		for (int i = 0; i < (int)order.size(); ++i)
+			id[order[i]] = i;
+
+		int levels = max_length - min_length + 1;
+		std::vector<int> count(levels);
+		for (int sym = 0; sym < (int)symbols.size(); ++sym)
+		{
+			if (frequency[sym])
+				count[code_length[sym] - min_length]++;
+		}
+
+		// Canonical code: the longest codes start at 0, a code of each length is worth half as much as
+		// the next code of one bit more
+		std::vector<int> lowest(levels);
+		std::vector<u64> base(levels);
+		for (int i = levels - 2; i >= 0; --i)
+		{
+			lowest[i] = lowest[i + 1] + count[i + 1];
+			check((base[i + 1] + count[i + 1]) % 2 == 0, "Incomplete Huffman code");
+			base[i] = (base[i + 1] + count[i + 1]) / 2;
+		}
+
+		c.sizes.push_back((uint8_t)flags);
+		c.sizes.push_back(BlockSizeLog);
+		c.sizes.push_back(SpanLog);
+		c.sizes.push_back(0);
+		size_t block_count_pos = c.sizes.size();
+		put32(c.sizes, 0);
+		c.sizes.push_back((uint8_t)max_length);
+		c.sizes.push_back((uint8_t)min_length);
+		for (int i = 0; i < levels; ++i)
+			put16(c.sizes, lowest[i]);
+
+		put16(c.sizes, (unsigned)symbols.size());
+		for (int i = 0; i < (int)order.size(); ++i)
+		{
+			const Symbol &sym = symbols[order[i]];
+			int left = sym.right < 0 ? sym.left : id[sym.left];
+			int right = sym.right < 0 ? 0xFFF : id[sym.right];
+			c.sizes.push_back(left & 0xFF);
+			c.sizes.push_back((uint8_t)((left >> 8) | ((right & 0xF) << 4)));
+			c.sizes.push_back((uint8_t)(right >> 4));
+		}
+		if (symbols.size() & 1)
+			c.sizes.push_back(0);
+
+		// The blocks, each holds whole symbols
+		const size_t block_bits = (size_t)8 << BlockSizeLog;
+		const size_t span = (size_t)1 << SpanLog;
+		const size_t max_block_values = 65536 - span;
+
+		std::vector<size_t> block_start;
+		std::vector<uint8_t> block;
+		size_t bits = 0, block_values = 0, total = 0;
+
+		auto closeBlock = [&]()
+		{
+			block.resize(block_bits / 8);
+			c.blocks.insert(c.blocks.end(), block.begin(), block.end());
+			put16(c.block_lengths, (unsigned)(block_values - 1));
+			block.clear();
+			bits = block_values = 0;
+		};
+
+		for (int sym : seq)
+		{
+			int length = code_length[sym];
+			int idx = id[sym];
+			int level = length - min_length;
+
+			if (!block_start.empty() && (bits + length > block_bits || block_values + symbols[sym].length > max_block_values))
+				closeBlock();
+			if (!bits && !block_values)
+				block_start.push_back(total);
+
+			u64 code = base[level] + (idx - lowest[level]);
+			for (int b = length - 1; b >= 0; --b)
+			{
+				if (bits % 8 == 0)
+					block.push_back(0);
+				if (code >> b & 1)
+					block.back() |= (uint8_t)(0x80 >> (bits % 8));
+				++bits;
+			}
+
+			block_values += symbols[sym].length;
+			total += symbols[sym].length;
+		}
+		closeBlock();
+
+		check(total == values.size(), "Symbols don't cover the values");
+		unsigned block_count = (unsigned)block_start.size();
+		for (int i = 0; i < 4; ++i)
+			c.sizes[block_count_pos + i] = (uint8_t)(block_count >> (8 * i));
+
+		// The sparse index holds the block and the offset of the value in the middle of each span,
+		// past the end it keeps counting in the last block
+		for (size_t k = 0; k < (values.size() + span - 1) / span; ++k)
+		{
+			size_t middle = k * span + span / 2;
+			size_t b = std::upper_bound(block_start.begin(), block_start.end(), std::min(middle, values.size() - 1)) - block_start.begin() - 1;
+			size_t offset = middle - block_start[b];
+			check(offset < 65536, "Sparse index offset out of range");
+			put32(c.sparse_index, (unsigned)b);
+			put16(c.sparse_index, (unsigned)offset);
+		}
+
+		return c;
+	}
+
+	// The description of a table file: its pieces in the order of the encoding, by index in the
+	// table, and the side to move of a DTZ table
+	struct TableFile
+	{
+		const Table *table;
+		std::vector<int> order;
+		bool pawns;
+		bool pawns_both_sides;
+		bool symmetric;
+		bool unique_pieces;
+	};
+
+	int code(const Piece &piece)
+	{
+		return piece.type | (piece.color << 3);
+	}
+
+	// The lengths of the groups of pieces encoded together and the factor of each in the index
+	struct Groups
+	{
+		std::vector<int> length;
+		std::vector<u64> factor;
+		u64 size;
+	};
+
+	Groups groups(const TableFile &tf)
+	{
+		Groups g;
+		std::vector<int> codes;
+		for (int i : tf.order)
+			codes.push_back(code(tf.table->pieces[i]));
+
+		// Without pawns the first three pieces are encoded together
+		int first = tf.pawns ? 1 : 3;
+		check(tf.pawns || tf.unique_pieces, "Only tables with a unique piece are written");
+
+		g.length.push_back(first);
+		for (size_t i = first; i < codes.size(); ++i)
+		{
+			if (codes[i] == codes[i - 1] && (tf.pawns || i > (size_t)first))
+				g.length.back()++;
+			else
+				g.length.push_back(1);
+		}
+
+		// The leading group varies fastest, then the pawns of the other side, then the pieces
+		int free_squares = 64 - g.length[0];
+		g.size = tf.pawns ? 6 : 31332;
+		g.factor.push_back(1);
+		check(!tf.pawns || g.length[0] == 1, "Only one leading pawn is supported");
+
+		for (size_t k = 1; k < g.length.size(); ++k)
+		{
+			g.factor.push_back(g.size);
+			if (k == 1 && tf.pawns_both_sides)
+			{
+				g.size *= Binomial[g.length[k]][48 - g.length[0]];
+				free_squares -= g.length[k];
+			}
+			else
+			{
+				g.size *= Binomial[g.length[k]][free_squares];
+				free_squares -= g.length[k];
+			}
+		}
+		return g;
+	}
+
+	// The index of a position in its table, and the file of the leading pawn
+	u64 encode(const TableFile &tf, const Groups &g, const Position &pos, int &file)
+	{
+		std::vector<int> sq;
+		for (int i : tf.order)
+			sq.push_back(pos.sq[i]);
+
+		auto transform = [&](const std::function<int(int)> &f, size_t from)
+		{
+			for (size_t i = from; i < sq.size(); ++i)
+				sq[i] = f(sq[i]);
+		};
+
+		u64 idx;
+		file = 0;
+
+		if (tf.pawns)
+		{
+			// One leading pawn, mirrored to the files a to d
+			if (fileOf(sq[0]) > 3)
+				transform([](int s) { return s ^ 7; }, 0);
+			file = fileOf(sq[0]);
+			idx = rankOf(sq[0]) - 1;
+		}
+		else
+		{
+			// The first piece is moved to the a1-d1-d4 triangle and the first piece off the diagonal
+			// below it
+			if (fileOf(sq[0]) > 3)
+				transform([](int s) { return s ^ 7; }, 0);
+			if (rankOf(sq[0]) > 3)
+				transform([](int s) { return s ^ 56; }, 0);
+
+			for (size_t i = 0; i < 3; ++i)
+			{
+				int off = rankOf(sq[i]) - fileOf(sq[i]);
+				if (off > 0)
+					transform([](int s) { return fileOf(s) * 8 + rankOf(s); }, i);
+				if (off)
+					break;
+			}
+
+			// b1, c1, d1, c2, d2, d3, then the diagonal a1, b2, c3, d4
+			static const int Triangle[] = {
+				6, 0, 1, 2, -1, -1, -1, -1,
+				-1, 7, 3, 4, -1, -1, -1, -1,
+				-1, -1, 8, 5, -1, -1, -1, -1,
+				-1, -1, -1, 9, -1, -1, -1, -1
+			};
+
+			auto below = [](int s)
+			{
+				int n = 0;
+				for (int t = 0; t < s; ++t)
+					n += rankOf(t) < fileOf(t);
+				return n;
+			};
+			auto off = [](int s) { return rankOf(s) - fileOf(s); };
+
+			int adjust1 = sq[1] > sq[0];
+			int adjust2 = (sq[2] > sq[0]) + (sq[2] > sq[1]);
+
+			if (off(sq[0]))
+				idx = ((u64)Triangle[sq[0]] * 63 + sq[1] - adjust1) * 62 + sq[2] - adjust2;
+			else if (off(sq[1]))
+				idx = (6 * 63 + (u64)rankOf(sq[0]) * 28 + below(sq[1])) * 62 + sq[2] - adjust2;
+			else if (off(sq[2]))
+				idx = 6 * 63 * 62 + 4 * 28 * 62 + rankOf(sq[0]) * 7 * 28 + (rankOf(sq[1]) - adjust1) * 28 + below(sq[2]);
+			else
+				idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rankOf(sq[0]) * 7 * 6 + (rankOf(sq[1]) - adjust1) * 6 + rankOf(sq[2]) - adjust2;
+		}
+
+		// The other groups as combinations of the squares the previous groups left
+		size_t start = g.length[0];
+		for (size_t k = 1; k < g.length.size(); ++k)
+		{
+			std::vector<int> group(sq.begin() + start, sq.begin() + start + g.length[k]);
+			std::sort(group.begin(), group.end());
+
+			u64 n = 0;
+			for (size_t i = 0; i < group.size(); ++i)
+			{
+				int adjust = (int)std::count_if(sq.begin(), sq.begin() + start, [&](int s) { return s < group[i]; });
+				if (k == 1 && tf.pawns_both_sides)
+					adjust += 8;
+				n += Binomial[i + 1][group[i] - adjust];
+			}
+
+			idx += n * g.factor[k];
+			start += g.length[k];
+		}
+
+		check(idx < g.size, "Index out of range");
+		return idx;
+	}
+
+	enum TableType
+	{
+		WDL, DTZ
+	};
+
+	// Writes the file, for DTZ with the given side to move, returns its size
+	size_t write(const TableFile &tf, TableType type, int dtz_stm, bool save)
+	{
+		const Table &table = *tf.table;
+		int sides = type == WDL && !tf.symmetric ? 2 : 1;
+		int files = tf.pawns ? 4 : 1;
+
+		// The values by side and file, -1 for the positions that are never probed
+		// The leading pawn has the same 6 squares on every file, so the files share their groups
+		Groups g = groups(tf);
+		std::vector<std::vector<int>> values(sides * files, std::vector<int>(g.size, -1));
+
+		for (u64 raw = 0; raw < table.value.size(); ++raw)
+		{
+			int value = table.value[raw];
+			if (value == Illegal)
+				continue;
+
+			Position pos = table.position(raw);
+			int side;
+			if (type == DTZ)
+			{
+				if (pos.stm != dtz_stm || !value)
+					continue;
+				side = 0;
+				value = abs(value) - 1;
+			}
+			else
+			{
+				if (tf.symmetric && pos.stm != WHITE)
+					continue;
+				side = tf.symmetric ? 0 : pos.stm;
+				value = value > 0 ? 4 : value < 0 ? 0 : 2;
+			}
+
+			int file;
+			u64 idx = encode(tf, g, pos, file);
+			int &stored = values[side * files + file][idx];
+			check(stored < 0 || stored == value, "Two positions of the same index differ in " + name(table.pieces));
+			stored = value;
+		}
+
+		// The values that are never probed repeat the previous one
+		for (std::vector<int> &v : values)
+		{
+			int previous = -1;
+			for (int &value : v)
+			{
+				if (value < 0)
+					value = previous;
+				else
+					previous = value;
+			}
+			int first = *std::find_if(v.begin(), v.end(), [](int value) { return value >= 0; });
+			for (int &value : v)
+			{
+				if (value >= 0)
+					break;
+				value = first;
+			}
+		}
+
+		std::vector<uint8_t> out;
+		static const uint8_t Magic[2][4] = { { 0x71, 0xE8, 0x23, 0x5D }, { 0xD7, 0x66, 0x0C, 0xA5 } };
+		out.insert(out.end(), Magic[type], Magic[type] + 4);
+		out.push_back((uint8_t)((tf.symmetric ? 0 : 1) | (tf.pawns ? 2 : 0)));
+
+		for (int file = 0; file < files; ++file)
+		{
+			out.push_back(0x00);
+			if (tf.pawns_both_sides)
+				out.push_back(0x11);
+			for (int i : tf.order)
+			{
+				int c = code(table.pieces[i]);
+				out.push_back((uint8_t)(c | (c << 4)));
+			}
+		}
+		if (out.size() & 1)
+			out.push_back(0);
+
+		int flags = type == DTZ ? dtz_stm | 4 | 8 : 0;
+		std::vector<Compressed> compressed;
+		for (int file = 0; file < files; ++file)
+		{
+			for (int side = 0; side < sides; ++side)
+			{
+				compressed.push_back(compress(values[side * files + file], flags));
+				out.insert(out.end(), compressed.back().sizes.begin(), compressed.back().sizes.end());
+			}
+		}
+		if (out.size() & 1)
+			out.push_back(0);
+
+		for (const Compressed &c : compressed)
+			out.insert(out.end(), c.sparse_index.begin(), c.sparse_index.end());
+		for (const Compressed &c : compressed)
+			out.insert(out.end(), c.block_lengths.begin(), c.block_lengths.end());
+		for (const Compressed &c : compressed)
+		{
+			out.resize((out.size() + 63) & ~(size_t)63);
+			out.insert(out.end(), c.blocks.begin(), c.blocks.end());
+		}
+		out.resize(((out.size() + 63) & ~(size_t)63) + 16);
+
+		if (save)
+		{
+			std::string file_name = name(table.pieces) + (type == WDL ? ".rtbw" : ".rtbz");
+			std::ofstream(file_name, std::ios::binary).write((const char*)out.data(), out.size());
+			printf("%s %zu bytes\n", file_name.c_str(), out.size());
+		}
+		return out.size();
+	}
+
+	// Prints the positions of the longest DTZ, for the tests
+	void printLongest(const Table &table)
+	{
+		int longest = 0;
+		for (int8_t value : table.value)
+		{
+			if (value != Illegal)
+				longest = std::max(longest, (int)value);
+		}
+
+		int printed = 0;
+		for (u64 raw = 0; raw < table.value.size() && printed < 3; ++raw)
+		{
+			if (table.value[raw] != longest)
+				continue;
+
+			Position pos = table.position(raw);
+			std::string fen;
+			for (int rank = 7; rank >= 0; --rank)
+			{
+				int empty = 0;
+				for (int f = 0; f < 8; ++f)
+				{
+					int i = pos.pieceAt(rank * 8 + f);
+					if (i < 0)
+					{
+						++empty;
+						continue;
+					}
+					if (empty)
+						fen += std::to_string(empty);
+					empty = 0;
+					char c = PieceChars[pos.type[i]];
+					fen += pos.color[i] == WHITE ? c : (char)(c - 'A' + 'a');
+				}
+				if (empty)
+					fen += std::to_string(empty);
+				if (rank)
+					fen += '/';
+			}
+			printf("  dtz %d: %s %c - - 0 1\n", longest, fen.c_str(), pos.stm == WHITE ? 'w' : 'b');
+			++printed;
+		}
+	}
+}
+
+int main()
+{
+	init();
+
+	struct Output
+	{
+		std::vector<Piece> pieces;
+		std::vector<int> order;
+	};
+
+	const std::vector<Output> outputs = {
+		{ { { WHITE, KING }, { WHITE, QUEEN }, { BLACK, KING } }, { 0, 1, 2 } },
+		{ { { WHITE, KING }, { WHITE, ROOK }, { BLACK, KING } }, { 0, 1, 2 } },
+		{ { { WHITE, KING }, { WHITE, BISHOP }, { BLACK, KING } }, { 0, 1, 2 } },
+		{ { { WHITE, KING }, { WHITE, KNIGHT }, { BLACK, KING } }, { 0, 1, 2 } },
+		{ { { WHITE, KING }, { WHITE, PAWN }, { BLACK, KING } }, { 1, 0, 2 } },
+		{ { { WHITE, KING }, { WHITE, BISHOP }, { WHITE, KNIGHT }, { BLACK, KING } }, { 0, 1, 2, 3 } },
+		{ { { WHITE, KING }, { WHITE, PAWN }, { BLACK, KING }, { BLACK, PAWN } }, { 1, 3, 0, 2 } },
+	};
+
+	for (const Output &output : outputs)
+	{
+		const Table &table = solve(output.pieces);
+		printLongest(table);
+
+		TableFile tf;
+		tf.table = &table;
+		tf.order = output.order;
+
+		int count[2][8] = {};
+		for (const Piece &piece : table.pieces)
+			count[piece.color][piece.type]++;
+
+		tf.pawns = count[WHITE][PAWN] || count[BLACK][PAWN];
+		tf.pawns_both_sides = count[WHITE][PAWN] && count[BLACK][PAWN];
+		tf.symmetric = std::equal(count[WHITE], count[WHITE] + 8, count[BLACK]);
+		tf.unique_pieces = false;
+		for (int color = WHITE; color <= BLACK; ++color)
+		{
+			for (int type = PAWN; type < KING; ++type)
+				tf.unique_pieces |= count[color][type] == 1;
+		}
+
+		write(tf, WDL, WHITE, true);
+
+		// The DTZ table keeps the side to move that compresses better, a symmetric table with pawns
+		// is always probed with white to move
+		int stm = WHITE;
+		if (!tf.symmetric && write(tf, DTZ, BLACK, false) < write(tf, DTZ, WHITE, false))
+			stm = BLACK;
+		write(tf, DTZ, stm, true);
+	}
+
+	return 0;
+}
@@ -2,16 +2,24 @@
 #include "CppUnitTest.h"
 
 #include "attacks.h"
+#include "bitbase.h"
 #include "bitboard_iterator.h"
 #include "board.h"
+#include "book.h"
 #include "evaluation.h"
+#include "match.h"
+#include "repetition.h"
 #include "search.h"
 #include "see.h"
+#include "tablebase.h"
+#include "transposition_table.h"
 #include "util.h"
 #include "zobrist.h"
 
 #include <locale>
 #include <codecvt>
+#include <cstdio>
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -316,6 +324,43 @@ namespace UnitTests
 			}
 		}
 
+		TEST_METHOD(hashAfter_Test)
+		{
+			initSquareBB();
+			initAttackTables();
+			Zobrist::initZobristHashing();
+
+			vector<string> fens = {
+				"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+				"r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b KQkq a3 0 1",
+				"n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+				"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3" };
+
+			for (const string &fen : fens)
+			{
+				Board board = Board::fromFen(fen);
+
+				Move moves[MAX_MOVES];
+				int move_count;
+
+				if (board.toMove() == WHITE)
+					MoveGen::genMoves<WHITE, false>(board, moves, move_count);
+				else
+					MoveGen::genMoves<BLACK, false>(board, moves, move_count);
+
+				for (int i = 0; i < move_count; ++i)
+				{
+					Board board_copy = board;
+					board_copy.makeMove(moves[i]);
+					Assert::AreEqual(board_copy.hash(), board.hashAfter(moves[i]));
+				}
+
+				Board board_copy = board;
+				board_copy.makeMove(Move::nullMove());
+				Assert::AreEqual(board_copy.hash(), board.hashAfter(Move::nullMove()));
+			}
+		}
+
 		TEST_METHOD(see_Test)
 		{
 			initSquareBB();
@@ -341,6 +386,10 @@ namespace UnitTests
 
 			board = Board::fromFen("r2qkb1r/p1pbpppp/1pnp1n2/8/Q2P4/2P1P3/PP3PPP/RNB1K1NR w KQkq - 0 6 ");
 			Assert::AreEqual(PieceValue[KNIGHT].mg - PieceValue[QUEEN].mg, see<WHITE>(board, Move::fromAlgebraic(board, "a4c6")));
+
+			board = Board::fromFen("4k3/8/3p4/8/8/8/8/3QK3 w - - 0 1");
+			Assert::AreEqual(-PieceValue[QUEEN].mg, see<WHITE>(board, Move::fromAlgebraic(board, "d1c5")));
+			Assert::AreEqual(0, see<WHITE>(board, Move::fromAlgebraic(board, "d1d4")));
 		}
 
 		TEST_METHOD(isPassedPawn_Test)
@@ -395,6 +444,35 @@ namespace UnitTests
 			Assert::AreEqual(std::string("r2qk1nr/2p1bp2/p1n5/1pPpPbp1/7p/1N2PN1P/PP3PPB/R2QKB1R w - b6 1 1"), flipped_board.fen());
 		}
 
+		TEST_METHOD(isDraw_Test)
+		{
+			initSquareBB();
+			initAttackTables();
+			Zobrist::initZobristHashing();
+
+			Board board = Board::fromFen("4k3/4p3/8/8/8/8/3P4/R3K3 w - - 98 60");
+
+			board.makeMove(Move::fromAlgebraic(board, "a1a2"));
+			Assert::AreEqual(99, board.halfmoveClock());
+			Assert::IsFalse(board.isDraw());
+
+			Board capture = Board::fromFen("4k3/8/8/8/8/8/3p4/R3K3 w - - 99 60");
+			capture.makeMove(Move::fromAlgebraic(capture, "e1d2"));
+			Assert::AreEqual(0, capture.halfmoveClock());
+
+			board.makeMove(Move::fromAlgebraic(board, "e8f8"));
+			Assert::AreEqual(100, board.halfmoveClock());
+			Assert::IsTrue(board.isDraw());
+
+			Assert::IsTrue(Board::fromFen("4k3/8/8/8/8/8/8/4K3 w - - 0 1").isDraw());
+			Assert::IsTrue(Board::fromFen("4k3/8/8/8/8/8/8/2B1K3 w - - 0 1").isDraw());
+			Assert::IsTrue(Board::fromFen("4kn2/8/8/8/8/8/8/2B1K3 w - - 0 1").isDraw());
+			Assert::IsTrue(Board::fromFen("4kb2/8/8/8/8/8/8/2B1K1B1 w - - 0 1").isDraw());
+			Assert::IsFalse(Board::fromFen("4k3/8/8/8/8/8/8/2BNK3 w - - 0 1").isDraw());
+			Assert::IsFalse(Board::fromFen("4k3/8/8/8/8/8/8/2B1KB2 w - - 0 1").isDraw());
+			Assert::IsFalse(Board::fromFen("4k3/8/8/8/8/8/8/R3K3 w - - 0 1").isDraw());
+		}
+
 		TEST_METHOD(evaluationSymmetry_Test)
 		{
 			initSquareBB();
@@ -420,6 +498,284 @@ namespace UnitTests
 			}
 		}
 
+		TEST_METHOD(evaluationParams_Test)
+		{
+			init();
+
+			Board board = Board::fromFen("r2qk1nr/1pp1bp2/p1n5/3pPbp1/7p/1NP1PN1P/PP3PPB/R2QKB1R w Kkq - 1 1");
+			int eval = Evaluation::evaluate<WHITE>(board);
+
+			Evaluation::saveParams(Evaluation::DefaultParams, "evaluation_params_test.txt");
+			Evaluation::loadParams("evaluation_params_test.txt");
+
+			Assert::IsTrue(Evaluation::UseCustomParams);
+			Assert::AreEqual(eval, Evaluation::evaluate<WHITE>(board));
+
+			Evaluation::CustomParams.TempoBonus = Score(100, 100);
+			Assert::IsTrue(Evaluation::evaluate<WHITE>(board) > eval);
+
+			Evaluation::resetParams();
+			Assert::AreEqual(eval, Evaluation::evaluate<WHITE>(board));
+
+			// Loading into local weights leaves the active evaluation alone
+			Evaluation::Params params;
+			Evaluation::loadParams("evaluation_params_test.txt", params);
+			params.TempoBonus = Score(100, 100);
+
+			Assert::IsFalse(Evaluation::UseCustomParams);
+			Assert::IsTrue(Evaluation::evaluate<WHITE>(board, params) > eval);
+			Assert::AreEqual(eval, Evaluation::evaluate<WHITE>(board));
+		}
+
+		TEST_METHOD(sprtLLR_Test)
+		{
+			Assert::AreEqual(0.0, Match::sprtLLR(0, 0, 0, 0.0, 5.0));
+			Assert::AreEqual(0.0, Match::sprtLLR(10, 0, 0, 0.0, 5.0));
+			Assert::AreEqual(0.0, Match::sprtLLR(0, 0, 10, 0.0, 5.0));
+
+			// Without losses the LLR still favors H1
+			Assert::IsTrue(Match::sprtLLR(10, 0, 5, 0.0, 5.0) > 0.0);
+
+			Assert::IsTrue(Match::sprtLLR(600, 400, 1000, 0.0, 5.0) > 2.94);
+			Assert::IsTrue(Match::sprtLLR(400, 600, 1000, 0.0, 5.0) < -2.94);
+			Assert::IsTrue(Match::sprtLLR(500, 500, 1000, 0.0, 5.0) < 0.0);
+		}
+
+		TEST_METHOD(RepetitionTable_Test)
+		{
+			initSquareBB();
+			initAttackTables();
+			Zobrist::initZobristHashing();
+
+			Board board = Board::fromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+			RepetitionTable table;
+			table.push(board.hash(), true);
+
+			// Knights out and back, the fourth move repeats the starting position
+			vector<string> moves = { "g1f3", "g8f6", "f3g1", "f6g8" };
+			for (int i = 0; i < (int)moves.size(); ++i)
+			{
+				Move move = Move::fromAlgebraic(board, moves[i]);
+				Board board_copy = board;
+				board_copy.makeMove(move);
+
+				Assert::AreEqual(i == 3, table.isRepetition(board_copy.hash(), RepetitionTable::isIrreversible(move)));
+
+				table.push(board_copy.hash(), RepetitionTable::isIrreversible(move));
+				board = board_copy;
+			}
+
+			// An irreversible move in between hides the earlier positions
+			table.clear();
+			board = Board::fromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+			table.push(board.hash(), true);
+
+			Board after_e4 = board;
+			after_e4.makeMove(Move::fromAlgebraic(after_e4, "e2e4"));
+			table.push(after_e4.hash(), true);
+			table.pop();
+			Assert::AreEqual(1, table.size());
+
+			Assert::IsTrue(RepetitionTable::isIrreversible(Move::nullMove()));
+			Assert::IsFalse(table.isRepetition(board.hash(), true));
+		}
+
+		TEST_METHOD(TranspositionTable_hashfull_Test)
+		{
+			TranspositionTable table(1);
+			Assert::AreEqual(0, table.hashfull());
+
+			// Half of the sampled entries, replacing an entry doesn't count it again
+			for (u64 hash = 1; hash <= 500; ++hash)
+				table.insert(hash, 1, 0, Move(), EXACT);
+			for (u64 hash = 1; hash <= 500; ++hash)
+				table.insert(hash, 2, 0, Move(), EXACT);
+			Assert::AreEqual(500, table.hashfull());
+
+			table.clear();
+			Assert::AreEqual(0, table.hashfull());
+		}
+
+		TEST_METHOD(PolyglotKey_Test)
+		{
+			initSquareBB();
+			initAttackTables();
+			Zobrist::initZobristHashing();
+
+			// The keys published with the Polyglot book format
+			Board board = Board::fromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+			Assert::IsTrue(Zobrist::polyglotKey(board) == 0x463b96181691fc9cULL);
+
+			// The en passant file is only in the key if a pawn can capture
+			board = Board::fromFen("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+			Assert::IsTrue(Zobrist::polyglotKey(board) == 0x823c9b50fd114196ULL);
+			board = Board::fromFen("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3");
+			Assert::IsTrue(Zobrist::polyglotKey(board) == 0x22a48b5a8e47ff78ULL);
+
+			// Lost castling rights
+			board = Board::fromFen("rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4");
+			Assert::IsTrue(Zobrist::polyglotKey(board) == 0x00fdd303c946bdd9ULL);
+			board = Board::fromFen("rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4");
+			Assert::IsTrue(Zobrist::polyglotKey(board) == 0x5c3f9b829b279560ULL);
+		}
+
+		TEST_METHOD(Book_Test)
+		{
+			initSquareBB();
+			initAttackTables();
+			Zobrist::initZobristHashing();
+
+			{
+				std::ofstream games("book_test_games.txt");
+				games << "e2e4 e7e5 g1f3" << std::endl;
+				games << "e2e4 c7c5 g1f3" << std::endl;
+				games << "e2e4 e7e5 f1c4" << std::endl;
+				games << "d2d4 d7d5 c2c4" << std::endl;
+			}
+			Assert::IsTrue(Book::build("book_test_games.txt", "book_test.bin", 2));
+
+			Book book;
+			Assert::IsTrue(book.open("book_test.bin"));
+
+			Board board = Board::fromFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+			Assert::IsTrue(book.probe(board, true) == Move::fromAlgebraic(board, "e2e4"));
+
+			board.makeMove(Move::fromAlgebraic(board, "e2e4"));
+			Assert::IsTrue(book.probe(board, true) == Move::fromAlgebraic(board, "e7e5"));
+			Move move = book.probe(board, false);
+			Assert::IsTrue(move == Move::fromAlgebraic(board, "e7e5") || move == Move::fromAlgebraic(board, "c7c5"));
+
+			// Only the first two plies of the games are in the book
+			board.makeMove(Move::fromAlgebraic(board, "e7e5"));
+			Assert::IsFalse(book.probe(board, true).isValid());
+
+			book.close();
+			std::remove("book_test_games.txt");
+			std::remove("book_test.bin");
+		}
+
+		TEST_METHOD(Tablebase_Test)
+		{
+			initSquareBB();
+			initAttackTables();
+			Zobrist::initZobristHashing();
+			Bitbase::init();
+
+			Tablebase::Wdl wdl;
+			int dtz;
+
+			// Nothing is probed without tables
+			Assert::AreEqual(0, Tablebase::init(""));
+			Assert::AreEqual(0, Tablebase::maxPieces());
+			Assert::IsFalse(Tablebase::probeWdl(Board::fromFen("8/8/8/8/4k3/8/Q7/K7 w - - 0 1"), wdl));
+
+			// The tables written by Test/syzygy/generate.cpp
+			std::string dir = __FILE__;
+			dir = dir.substr(0, dir.find_last_of("\\/")) + "/../Test/syzygy";
+			Assert::AreEqual(7, Tablebase::init(dir));
+			Assert::AreEqual(4, Tablebase::maxPieces());
+
+			Assert::IsTrue(Tablebase::probeWdl(Board::fromFen("8/8/8/8/4k3/8/Q7/K7 w - - 0 1"), wdl));
+			Assert::AreEqual((int)Tablebase::WDL_WIN, (int)wdl);
+			Assert::IsTrue(Tablebase::probeWdl(Board::fromFen("8/8/8/8/4k3/8/Q7/K7 b - - 0 1"), wdl));
+			Assert::AreEqual((int)Tablebase::WDL_LOSS, (int)wdl);
+
+			// Stalemate, and the lone king taking the undefended queen
+			Assert::IsTrue(Tablebase::probeWdl(Board::fromFen("k7/2Q5/1K6/8/8/8/8/8 b - - 0 1"), wdl));
+			Assert::AreEqual((int)Tablebase::WDL_DRAW, (int)wdl);
+			Assert::IsTrue(Tablebase::probeWdl(Board::fromFen("8/8/8/8/8/1k6/1Q6/6K1 b - - 0 1"), wdl));
+			Assert::AreEqual((int)Tablebase::WDL_DRAW, (int)wdl);
+
+			// Mate in one
+			Assert::IsTrue(Tablebase::probeDtz(Board::fromFen("7k/8/6K1/8/8/8/8/R7 w - - 0 1"), dtz));
+			Assert::AreEqual(1, dtz);
+
+			// The longest wins: mate in 10 with the queen, in 16 with the rook and in 33 with the bishop and the knight
+			Assert::IsTrue(Tablebase::probeDtz(Board::fromFen("7K/6Q1/8/8/8/3k4/8/8 w - - 0 1"), dtz));
+			Assert::AreEqual(19, dtz);
+			Assert::IsTrue(Tablebase::probeDtz(Board::fromFen("7K/8/8/8/8/8/2k5/1R6 w - - 0 1"), dtz));
+			Assert::AreEqual(31, dtz);
+			Assert::IsTrue(Tablebase::probeDtz(Board::fromFen("8/8/8/8/8/7B/8/Nk5K w - - 0 1"), dtz));
+			Assert::AreEqual(65, dtz);
+
+			// A minor piece alone doesn't win, so neither does the bishop and the knight when the king takes one
+			Assert::IsTrue(Tablebase::probeWdl(Board::fromFen("8/8/8/8/8/8/8/kBK5 w - - 0 1"), wdl));
+			Assert::AreEqual((int)Tablebase::WDL_DRAW, (int)wdl);
+			Assert::IsTrue(Tablebase::probeWdl(Board::fromFen("8/8/8/8/8/8/8/kNK5 b - - 0 1"), wdl));
+			Assert::AreEqual((int)Tablebase::WDL_DRAW, (int)wdl);
+			Assert::IsTrue(Tablebase::probeWdl(Board::fromFen("8/8/8/8/8/8/1k6/NB5K b - - 0 1"), wdl));
+			Assert::AreEqual((int)Tablebase::WDL_DRAW, (int)wdl);
+
+			// The king and pawn tables agree with the bitbase, here with the pawn on e5 and the lone king on the last rank
+			for (int king = A1; king <= H8; ++king)
+			{
+				for (int weak_king = A8; weak_king <= H8; ++weak_king)
+				{
+					if (king == E5 || king == weak_king)
+						continue;
+
+					std::string squares(64, '1');
+					squares[king] = 'K';
+					squares[weak_king] = 'k';
+					squares[E5] = 'P';
+
+					std::string fen;
+					for (int rank = 7; rank >= 0; --rank)
+						fen += squares.substr(rank * 8, 8) + (rank ? "/" : "");
+
+					for (Color to_move : { WHITE, BLACK })
+					{
+						Board board = Board::fromFen(fen + (to_move == WHITE ? " w" : " b") + " - - 0 1");
+						if (board.isInCheck(~to_move))
+							continue;
+
+						Assert::IsTrue(Tablebase::probeWdl(board, wdl));
+						bool win = wdl == (to_move == WHITE ? Tablebase::WDL_WIN : Tablebase::WDL_LOSS);
+						Assert::AreEqual(Bitbase::probeKpk(WHITE, (Square)king, E5, (Square)weak_king, to_move), win);
+					}
+				}
+			}
+
+			// Pawn against pawn: only the side to move gets to the other pawn in time, and the en passant
+			// capture wins a position the table alone draws
+			Assert::IsTrue(Tablebase::probeDtz(Board::fromFen("8/8/8/7k/1p6/1P6/7K/8 b - - 0 1"), dtz));
+			Assert::AreEqual(21, dtz);
+			Assert::IsTrue(Tablebase::probeDtz(Board::fromFen("8/8/8/7k/1p6/1P6/7K/8 w - - 0 1"), dtz));
+			Assert::AreEqual(0, dtz);
+			Assert::IsTrue(Tablebase::probeWdl(Board::fromFen("8/8/8/Pp6/8/8/8/K1k5 w - - 0 1"), wdl));
+			Assert::AreEqual((int)Tablebase::WDL_DRAW, (int)wdl);
+			Assert::IsTrue(Tablebase::probeWdl(Board::fromFen("8/8/8/Pp6/8/8/8/K1k5 w - b6 0 1"), wdl));
+			Assert::AreEqual((int)Tablebase::WDL_WIN, (int)wdl);
+
+			Tablebase::init("");
+		}
+
+		TEST_METHOD(KpkBitbase_Test)
+		{
+			initSquareBB();
+			initAttackTables();
+			Bitbase::init();
+
+			// The opposition decides with the king in front of the pawn, but not on the sixth rank
+			Assert::IsTrue(Bitbase::probeKpk(WHITE, E5, E4, E7, BLACK));
+			Assert::IsFalse(Bitbase::probeKpk(WHITE, E5, E4, E7, WHITE));
+			Assert::IsTrue(Bitbase::probeKpk(WHITE, E6, E5, E8, WHITE));
+
+			// The rook pawn can't win against a king in the corner
+			Assert::IsFalse(Bitbase::probeKpk(WHITE, B6, A5, A8, WHITE));
+
+			// The lone king is too far from the pawn
+			Assert::IsTrue(Bitbase::probeKpk(WHITE, A1, H4, A8, BLACK));
+			Assert::IsFalse(Bitbase::probeKpk(WHITE, A1, H4, E6, BLACK));
+
+			// Mirrored for black
+			Assert::IsTrue(Bitbase::probeKpk(BLACK, E4, E5, E2, WHITE));
+			Assert::IsFalse(Bitbase::probeKpk(BLACK, E4, E5, E2, BLACK));
+
+			Assert::IsTrue(Evaluation::evaluate<WHITE>(Board::fromFen("8/4k3/8/4K3/4P3/8/8/8 b - - 0 1")) > SCORE_KNOWN_WIN);
+			Assert::AreEqual(0, Evaluation::evaluate<WHITE>(Board::fromFen("8/4k3/8/4K3/4P3/8/8/8 w - - 0 1")));
+		}
+
 		//TEST_METHOD(searchSymmetry_Test)
 		//{
 		//	initSquareBB();